@@ -0,0 +1,50 @@
+#ifndef _BLOCKYTRY_CORE_ALLOC_TRACKER_H_
+#define _BLOCKYTRY_CORE_ALLOC_TRACKER_H_
+
+#include <cstdint>
+
+namespace fost
+{
+namespace alloc
+{
+
+// Heap activity through the global operator new and delete.
+struct counts
+{
+    std::uint64_t allocations;
+    std::uint64_t frees;
+    std::uint64_t bytes;        // Requested bytes, frees are not subtracted.
+};
+
+// Totals of the calling thread since it started. Only the build with
+// BLOCKYTRY_TRACK_ALLOCATIONS replaces operator new and delete, otherwise
+// these stay zero. Constant initialized, so allocations made during static
+// initialization count too.
+inline thread_local counts tl_counts {0U, 0U, 0U};
+
+constexpr bool is_tracking ()
+{
+#ifdef FOST_TRACK_ALLOCATIONS
+    return true;
+#else
+    return false;
+#endif
+}
+
+inline const counts & thread_counts ()
+{
+    return tl_counts;
+}
+
+// Activity of the calling thread since start was taken with thread_counts ().
+inline const counts since (const counts &start)
+{
+    return {tl_counts.allocations - start.allocations,
+            tl_counts.frees - start.frees,
+            tl_counts.bytes - start.bytes};
+}
+
+} // namespace alloc
+} // namespace fost
+
+#endif // _BLOCKYTRY_CORE_ALLOC_TRACKER_H_
@@ -0,0 +1,139 @@
+#ifndef _BLOCKYTRY_CORE_BINDINGS_H_
+#define _BLOCKYTRY_CORE_BINDINGS_H_
+
+#include <array>
+#include <cstddef>
+#include <string_view>
+
+#include <shared/lookup_table.hpp>
+
+namespace fost
+{
+namespace input
+{
+
+// Key of an action bound to nothing, same as GLFW_KEY_UNKNOWN.
+constexpr int unbound = -1;
+
+// Every action by name with its default key, declared once:
+//
+//     static constexpr fost::input::action_table <2> actions {{
+//         {"jump", GLFW_KEY_SPACE},
+//         {"crouch", GLFW_KEY_C},
+//     }};
+//     static_assert (fost::input::unique_keys (actions));
+//     static fost::input::bindings g_bindings {actions};
+//
+//     if (key_down (g_bindings.key (fost::input::action (actions, "jump"))))
+template <std::size_t size>
+using action_table = shared::lut <std::string_view, int, size>;
+
+// Dense index of an action, resolved at compile time. A name not in the
+// table does not compile.
+template <std::size_t size>
+consteval std::size_t action (const action_table <size> &table, const char *name)
+{
+    return shared::index_of (table, name);
+}
+
+// False if two actions share a default key.
+template <std::size_t size>
+consteval bool unique_keys (const action_table <size> &table)
+{
+    for (std::size_t i = 0U; i < size; ++i)
+        for (std::size_t j = i + 1U; j < size; ++j)
+            if (table[i].second != unbound && table[i].second == table[j].second)
+                return false;
+    return true;
+}
+
+// The key each action is bound to now. Starts at the defaults, and the user
+// rebinds from there. A query is one index into a small array.
+template <std::size_t _Count>
+class bindings
+{
+public:
+    constexpr explicit bindings (const action_table <_Count> &table)
+        : _table {table}
+    {
+        restore_defaults ();
+    }
+
+    inline const int key (const std::size_t action) const
+    {
+        return _keys[action];
+    }
+
+    inline const std::string_view name (const std::size_t action) const
+    {
+        return _table[action].first;
+    }
+
+    inline const int default_key (const std::size_t action) const
+    {
+        return _table[action].second;
+    }
+
+    // Left unbound by a clash and not rebound since.
+    inline const bool is_clashed (const std::size_t action) const
+    {
+        return _clashed[action];
+    }
+
+    static constexpr std::size_t size ()
+    {
+        return _Count;
+    }
+
+    // Binds action to key. If another action is already on key, that is a
+    // clash: both end up unbound until the user rebinds one of them, rather
+    // than one silently taking the key from the other. Returns false then.
+    constexpr const bool rebind (const std::size_t action, const int key)
+    {
+        _keys[action] = key;
+        _clashed[action] = false;
+        if (key == unbound)
+            return true;
+
+        bool clash = false;
+        for (std::size_t other = 0U; other < _Count; ++other)
+        {
+            if (other != action && _keys[other] == key)
+            {
+                _keys[other] = unbound;
+                _clashed[other] = true;
+                clash = true;
+            }
+        }
+        if (clash)
+        {
+            _keys[action] = unbound;
+            _clashed[action] = true;
+        }
+        return ! clash;
+    }
+
+    constexpr void unbind (const std::size_t action)
+    {
+        rebind (action, unbound);
+    }
+
+    constexpr void restore_defaults ()
+    {
+        for (std::size_t action = 0U; action < _Count; ++action)
+        {
+            _keys[action] = _table[action].second;
+            _clashed[action] = false;
+        }
+    }
+
+private:
+    action_table <_Count> _table;
+    std::array <int, _Count> _keys {};
+    std::array <bool, _Count> _clashed {};
+};
+
+} // namespace input
+} // namespace fost
+
+#endif // _BLOCKYTRY_CORE_BINDINGS_H_
@@ -0,0 +1,117 @@
+#ifndef _BLOCKYTRY_CORE_CAPTURE_H_
+#define _BLOCKYTRY_CORE_CAPTURE_H_
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "alloc_tracker.hpp"
+#include "capture_format.hpp"
+#include "cpu_profiler.hpp"
+#include "runtime.hpp"
+
+namespace fost
+{
+namespace capture
+{
+
+// Starts writing a binary capture (see capture_format.hpp) to path.
+// Returns false if the file could not be opened.
+const bool start (const std::string &path);
+
+// Flushes buffered records and closes the capture. No-op if not recording.
+void stop ();
+
+const bool is_recording ();
+
+// Buffers one frame. Call once per frame after its ticks have run, with the
+// allocations the frame made (see alloc::since).
+void record_frame (const clock::time_point begin, const clock::duration duration, const std::uint32_t ticks,
+                   const alloc::counts &allocations);
+
+// Buffers one tick.
+void record_tick (const clock::time_point begin, const clock::duration duration);
+
+// Moves zones published since the last call by every thread profiler into the
+// capture. Call once per frame.
+void collect_zones ();
+
+// Header for a capture whose records are relative to origin.
+const file_header make_header (const clock::rep origin);
+
+// Appends a name_entry and its padded string to a serialized names or threads chunk.
+void append_name (std::vector <char> &chunk, const std::uint32_t id, const std::string_view str);
+
+// Frame record relative to origin.
+const frame_entry make_frame (const clock::rep origin, const clock::time_point begin, const clock::duration duration,
+                              const std::uint32_t ticks, const alloc::counts &allocations);
+
+// Nanoseconds from origin to t, as stored in capture records.
+inline std::int64_t relative_ns (const clock::rep origin, const clock::rep t)
+{
+    return std::chrono::duration_cast <std::chrono::nanoseconds> (clock::duration {t - origin}).count ();
+}
+
+// Turns zones published by the thread profilers into capture records,
+// interning zone and thread names along the way. Used by every capture sink.
+class zone_collector
+{
+public:
+    // Forgets all names and starts from the zones published after this call.
+    void reset (const clock::rep origin);
+
+    // Drains new zones. For each zone, on_thread (id, name) and on_name (id,
+    // name) are called first if the zone introduces them, then on_zone (entry).
+    // Not thread safe, each sink owns its collector.
+    template <class _OnThread, class _OnName, class _OnZone>
+    void collect (_OnThread &&on_thread, _OnName &&on_name, _OnZone &&on_zone)
+    {
+        cpu_profiler::for_each ([&] (const cpu_profiler &profiler)
+        {
+            cursor &c = find_cursor (profiler.thread_id (), 0U);
+            if (! c.announced)
+            {
+                on_thread (c.tid, profiler.thread_name ());
+                c.announced = true;
+            }
+
+            _scratch.clear ();
+            profiler.collect (c.position, _scratch);
+            for (const auto &zone : _scratch)
+            {
+                auto [name, inserted] = _name_ids.try_emplace (zone.name, static_cast <std::uint32_t> (_name_ids.size ()));
+                if (inserted)
+                    on_name (name->second, zone.name);
+
+                on_zone (zone_entry {relative_ns (_origin, zone.begin), relative_ns (_origin, zone.end),
+                                     name->second, static_cast <std::uint16_t> (c.tid), zone.depth, zone.allocations,
+                                     static_cast <std::uint32_t> (std::min <std::uint64_t> (zone.allocated_bytes, UINT32_MAX))});
+            }
+        });
+    }
+
+private:
+    struct cursor
+    {
+        std::uint32_t tid;
+        std::uint64_t position;
+        bool announced;
+    };
+
+    cursor & find_cursor (const std::uint32_t tid, const std::uint64_t position);
+
+    clock::rep _origin = 0;
+    // Zone names are string literals, so their address identifies them.
+    std::unordered_map <const char*, std::uint32_t> _name_ids;
+    std::vector <cursor> _cursors;
+    std::vector <fost::zone_record> _scratch;
+};
+
+} // namespace capture
+} // namespace fost
+
+#endif // _BLOCKYTRY_CORE_CAPTURE_H_
@@ -0,0 +1,97 @@
+#ifndef _BLOCKYTRY_CORE_CAPTURE_FORMAT_H_
+#define _BLOCKYTRY_CORE_CAPTURE_FORMAT_H_
+
+// Binary capture layout shared by the game and tools/framegrapher.
+// Keep this header free of game dependencies and valid C++17.
+//
+// A capture is a file_header followed by chunks. Each chunk is a chunk_header
+// followed by `bytes` bytes of payload holding `count` records. Fixed size
+// records are stored as plain arrays so a reader can map the file and use
+// them in place. All values are native (little) endian, times are
+// nanoseconds relative to file_header::start_ns.
+
+#include <cstddef>
+#include <cstdint>
+
+namespace fost
+{
+namespace capture
+{
+
+constexpr char magic[8] = {'F', 'O', 'S', 'T', 'C', 'A', 'P', '\0'};
+constexpr std::uint32_t version = 2U;
+
+struct file_header
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t tps;          // Tick rate when the capture started.
+    std::int64_t start_ns;      // Game clock time every record is relative to.
+    std::int64_t wall_start_s;  // Seconds since the Unix epoch, informational.
+};
+
+enum class chunk_type : std::uint32_t
+{
+    frames = 1U,    // frame_entry[count]
+    ticks = 2U,     // tick_entry[count]
+    zones = 3U,     // zone_entry[count]
+    names = 4U,     // count x (name_entry, char[length]), each padded to 8 bytes
+    threads = 5U,   // count x (name_entry, char[length]), each padded to 8 bytes
+};
+
+struct chunk_header
+{
+    chunk_type type;
+    std::uint32_t count;
+    std::uint64_t bytes;
+};
+
+struct frame_entry
+{
+    std::int64_t begin_ns;
+    std::int64_t duration_ns;
+    std::uint32_t ticks;        // Ticks simulated during this frame.
+    std::uint32_t allocations;  // Heap allocations by the frame's thread, 0 if untracked.
+    std::uint64_t allocated_bytes;
+};
+
+struct tick_entry
+{
+    std::int64_t begin_ns;
+    std::int64_t duration_ns;
+};
+
+struct zone_entry
+{
+    std::int64_t begin_ns;
+    std::int64_t end_ns;
+    std::uint32_t name_id;      // Refers to a names chunk entry.
+    std::uint16_t thread_id;    // Refers to a threads chunk entry.
+    std::uint16_t depth;
+    std::uint32_t allocations;      // Heap allocations inside the zone, 0 if untracked.
+    std::uint32_t allocated_bytes;  // Saturates at 4 GiB.
+};
+
+// Header of a variable length string, used by names and threads chunks.
+struct name_entry
+{
+    std::uint32_t id;
+    std::uint32_t length;
+};
+
+constexpr std::size_t padded_size (const std::size_t bytes)
+{
+    return (bytes + 7U) & ~static_cast <std::size_t> (7U);
+}
+
+static_assert (sizeof (file_header) == 32, "capture file_header layout changed");
+static_assert (sizeof (chunk_header) == 16, "capture chunk_header layout changed");
+static_assert (sizeof (frame_entry) == 32, "capture frame_entry layout changed");
+static_assert (sizeof (tick_entry) == 16, "capture tick_entry layout changed");
+static_assert (sizeof (zone_entry) == 32, "capture zone_entry layout changed");
+static_assert (sizeof (name_entry) == 8, "capture name_entry layout changed");
+
+} // namespace capture
+} // namespace fost
+
+#endif // _BLOCKYTRY_CORE_CAPTURE_FORMAT_H_
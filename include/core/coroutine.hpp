@@ -0,0 +1,142 @@
+#ifndef _BLOCKYTRY_CORE_COROUTINE_H_
+#define _BLOCKYTRY_CORE_COROUTINE_H_
+
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+
+#include "runtime.hpp"
+
+namespace fost
+{
+
+namespace detail
+{
+
+// Coroutine frames come from size classed free lists that only grow, so
+// starting a coroutine does not hit the heap once the pools are warm. Frames
+// too large for any class fall back to operator new.
+void * allocate_frame (const std::size_t size);
+void free_frame (void *frame, const std::size_t size) noexcept;
+
+// Queues h to resume on the game thread delay ticks from now.
+void schedule (std::coroutine_handle <> h, const std::int64_t delay);
+
+// Queues h to resume on a job worker.
+void schedule_on_worker (std::coroutine_handle <> h);
+const bool has_workers ();
+
+} // namespace detail
+
+// Fire and forget coroutine. It starts running as soon as it is called and
+// its frame is released when it returns. Use it for behaviour spanning
+// several ticks:
+//
+//     fost::task fade_out ()
+//     {
+//         for (int i = 0; i < 10; ++i)
+//         {
+//             step ();
+//             co_await fost::runtime::next_tick ();
+//         }
+//     }
+class task
+{
+public:
+    struct promise_type
+    {
+        task get_return_object () noexcept { return {}; }
+        std::suspend_never initial_suspend () noexcept { return {}; }
+        std::suspend_never final_suspend () noexcept { return {}; }
+        void return_void () noexcept {}
+        void unhandled_exception () noexcept { std::terminate (); }
+
+        static void * operator new (const std::size_t size)
+        {
+            return detail::allocate_frame (size);
+        }
+
+        static void operator delete (void *frame, const std::size_t size) noexcept
+        {
+            detail::free_frame (frame, size);
+        }
+    };
+};
+
+namespace runtime
+{
+
+// Suspends until the given number of ticks have passed. Resumes on the game
+// thread, from resume_coroutines ().
+struct tick_awaiter
+{
+    std::int64_t delay;
+
+    inline bool await_ready () const noexcept
+    {
+        return (delay <= 0);
+    }
+
+    inline void await_suspend (std::coroutine_handle <> h) const
+    {
+        fost::detail::schedule (h, delay);
+    }
+
+    inline void await_resume () const noexcept {}
+};
+
+// Moves the coroutine to a job worker. Runs inline without workers.
+struct worker_awaiter
+{
+    inline bool await_ready () const noexcept
+    {
+        return ! fost::detail::has_workers ();
+    }
+
+    inline void await_suspend (std::coroutine_handle <> h) const
+    {
+        fost::detail::schedule_on_worker (h);
+    }
+
+    inline void await_resume () const noexcept {}
+};
+
+inline tick_awaiter next_tick ()
+{
+    return {1};
+}
+
+inline tick_awaiter after (const ticks delay)
+{
+    return {delay.count ()};
+}
+
+inline worker_awaiter on_worker ()
+{
+    return {};
+}
+
+// Advances the coroutine tick and resumes every coroutine due. Call once per
+// tick on the game thread.
+void resume_coroutines ();
+
+// Ticks counted by resume_coroutines ().
+const std::int64_t coroutine_tick ();
+
+// Coroutines waiting for a tick.
+const std::size_t suspended_coroutines ();
+
+// Runs jobs until every coroutine resumed on a worker has suspended on a tick
+// or finished. Call at shutdown from a worker, before jobs::shutdown (), which
+// would drop those resumes and leak their frames.
+void wait_worker_coroutines ();
+
+// Destroys every coroutine still waiting for a tick. Call at shutdown, after
+// the job workers are gone.
+void destroy_coroutines ();
+
+} // namespace runtime
+} // namespace fost
+
+#endif // _BLOCKYTRY_CORE_COROUTINE_H_
@@ -1,36 +1,264 @@
 #ifndef _BLOCKYTRY_CORE_CPU_PROFILER_H_
 #define _BLOCKYTRY_CORE_CPU_PROFILER_H_
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 
+#include "alloc_tracker.hpp"
+#include "perf_counters.hpp"
+#include "runtime.hpp"
+
+// -=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+// PROFILING macros
+// -=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+// Zones are only compiled in when FOST_PROFILER is defined (see the
+// BLOCKYTRY_ENABLE_PROFILER option). Zone names must outlive the profiler, so
+// pass string literals. Counter zones also sample hardware counters when
+// fost::perf is enabled and available; reading them costs two syscalls, so
+// keep them to a few hot zones.
+#define FOST_PROFILE_CONCAT_IMPL(a, b) a##b
+#define FOST_PROFILE_CONCAT(a, b) FOST_PROFILE_CONCAT_IMPL (a, b)
+
+#ifdef FOST_PROFILER
+    #define FOST_PROFILE_ZONE(name) \
+        const fost::cpu_zone FOST_PROFILE_CONCAT (_fost_zone_, __LINE__) {name}
+    #define FOST_PROFILE_FUNCTION() FOST_PROFILE_ZONE (__func__)
+    #define FOST_PROFILE_ZONE_COUNTERS(name) \
+        const fost::cpu_counter_zone FOST_PROFILE_CONCAT (_fost_zone_, __LINE__) {name}
+#else
+    #define FOST_PROFILE_ZONE(name)
+    #define FOST_PROFILE_FUNCTION()
+    #define FOST_PROFILE_ZONE_COUNTERS(name)
+#endif
 
 namespace fost
 {
 
+// Timestamp used by all profiler records, in fost::clock ticks since its epoch.
+inline clock::rep profiler_now ()
+{
+    return clock::now ().time_since_epoch ().count ();
+}
+
+// A finished zone, as stored in the per-thread buffer.
+struct zone_record
+{
+    const char *name;
+    clock::rep begin;
+    clock::rep end;
+    std::uint16_t depth;
+    // Set by counter zones that could read hardware counters.
+    bool has_counters;
+    // Heap allocations made by the thread while the zone was open, children
+    // included. Zero unless built with BLOCKYTRY_TRACK_ALLOCATIONS.
+    std::uint32_t allocations;
+    // Counter deltas over the zone, valid when has_counters is set.
+    perf::sample counters;
+    std::uint64_t allocated_bytes;
+};
+
 class cpu_profiler
 {
-    cpu_profiler () 
-    {
-        std::cout << "Initialized CPU profiler.\n";
-    }
-    
-    ~cpu_profiler ()
-    {
-        std::cout << "Clean up CPU profiler.\n";
-    }
+    cpu_profiler ();
+    explicit cpu_profiler (const std::string &track_name);
 
     cpu_profiler (const cpu_profiler &other) = delete;
     cpu_profiler (cpu_profiler &&other) = delete;
     cpu_profiler & operator= (const cpu_profiler &other) = delete;
     cpu_profiler & operator= (cpu_profiler &&other) = delete;
- 
+
 public:
+    // Zone records kept per thread. Once full, the oldest records are overwritten.
+    static constexpr std::size_t capacity = 1U << 15;
+
+    ~cpu_profiler ();
+
     static cpu_profiler & get ()
     {
         static thread_local cpu_profiler instance;
         return instance;
     }
+
+    // Creates a profiler not bound to any thread, for zones timed elsewhere
+    // (e.g. on the GPU) that should show up as their own track. Only one
+    // thread may publish () to it.
+    static std::unique_ptr <cpu_profiler> make_track (const std::string &name);
+
+    // Opens a zone on the owning thread and returns its nesting depth.
+    inline std::uint16_t enter ()
+    {
+        return _depth++;
+    }
+
+    // Closes the innermost zone on the owning thread and publishes its record.
+    // Only the owning thread writes, so publishing is a single release store.
+    // allocs is the thread's alloc::thread_counts () when the zone opened.
+    inline void leave (const char *name, const clock::rep begin, const std::uint16_t depth,
+                       const alloc::counts &allocs)
+    {
+        const std::uint64_t head = _head.load (std::memory_order_relaxed);
+        zone_record &r = _records[head & (capacity - 1)];
+        r.name = name;
+        r.begin = begin;
+        r.end = profiler_now ();
+        r.depth = depth;
+        r.has_counters = false;
+        set_allocations (r, allocs);
+        _head.store (head + 1, std::memory_order_release);
+        --_depth;
+    }
+
+    // Same as above, for a zone that sampled hardware counters.
+    inline void leave (const char *name, const clock::rep begin, const std::uint16_t depth,
+                       const alloc::counts &allocs, const clock::rep end, const perf::sample &counters)
+    {
+        const std::uint64_t head = _head.load (std::memory_order_relaxed);
+        zone_record &r = _records[head & (capacity - 1)];
+        r.name = name;
+        r.begin = begin;
+        r.end = end;
+        r.depth = depth;
+        r.has_counters = true;
+        r.counters = counters;
+        set_allocations (r, allocs);
+        _head.store (head + 1, std::memory_order_release);
+        --_depth;
+    }
+
+    // Publishes a finished record as is, for tracks filled from outside.
+    inline void publish (const zone_record &record)
+    {
+        const std::uint64_t head = _head.load (std::memory_order_relaxed);
+        _records[head & (capacity - 1)] = record;
+        _head.store (head + 1, std::memory_order_release);
+    }
+
+    // Appends every record published after cursor to out and advances cursor.
+    // May be called from any thread. Records overwritten before they could be
+    // read are skipped. Returns the number of records appended.
+    std::size_t collect (std::uint64_t &cursor, std::vector <zone_record> &out) const;
+
+    // Total number of records ever published by this thread.
+    inline std::uint64_t published () const
+    {
+        return _head.load (std::memory_order_acquire);
+    }
+
+    // Small sequential id, unique among live and past threads.
+    inline std::uint32_t thread_id () const
+    {
+        return _thread_id;
+    }
+
+    // Copy of the owning thread's name, safe to call from any thread.
+    const std::string thread_name () const;
+
+    // Calls fn with every live thread profiler. Threads cannot register or
+    // exit while fn runs, so keep it short.
+    template <class _Fn>
+    static void for_each (_Fn &&fn)
+    {
+        std::lock_guard <std::mutex> lock {registry_mutex ()};
+        for (const cpu_profiler *profiler : registry ())
+            fn (*profiler);
+    }
+
+private:
+    friend void set_thread_name (const std::string &tname);
+
+    static std::mutex & registry_mutex ();
+    static std::vector <cpu_profiler*> & registry ();
+
+    static inline void set_allocations (zone_record &r, const alloc::counts &allocs)
+    {
+        const alloc::counts delta = alloc::since (allocs);
+        r.allocations = static_cast <std::uint32_t> (delta.allocations);
+        r.allocated_bytes = delta.bytes;
+    }
+
+    std::unique_ptr <zone_record[]> _records;
+    std::atomic <std::uint64_t> _head;
+    std::uint16_t _depth;
+    std::uint32_t _thread_id;
+    mutable std::mutex _thread_name_mutex;
+    std::string _thread_name;
+};
+
+// RAII zone. Use through FOST_PROFILE_ZONE so it compiles away when disabled.
+class cpu_zone
+{
+public:
+    explicit cpu_zone (const char *name)
+        : _profiler {cpu_profiler::get ()}
+        , _name {name}
+        , _depth {_profiler.enter ()}
+        , _allocs {alloc::thread_counts ()}
+        , _begin {profiler_now ()}
+    {}
+
+    ~cpu_zone ()
+    {
+        _profiler.leave (_name, _begin, _depth, _allocs);
+    }
+
+    cpu_zone (const cpu_zone &other) = delete;
+    cpu_zone & operator= (const cpu_zone &other) = delete;
+
+private:
+    cpu_profiler &_profiler;
+    const char *_name;
+    const std::uint16_t _depth;
+    const alloc::counts _allocs;
+    const clock::rep _begin;
+};
+
+// RAII zone that also records hardware counter deltas. Falls back to a plain
+// zone when counters are disabled or unavailable.
+class cpu_counter_zone
+{
+public:
+    explicit cpu_counter_zone (const char *name)
+        : _profiler {cpu_profiler::get ()}
+        , _name {name}
+        , _depth {_profiler.enter ()}
+        , _sampling {perf::available ()}
+        , _start {_sampling ? perf::read () : perf::sample {}}
+        , _allocs {alloc::thread_counts ()}
+        , _begin {profiler_now ()}
+    {}
+
+    ~cpu_counter_zone ()
+    {
+        const clock::rep end = profiler_now ();
+        if (! _sampling)
+        {
+            _profiler.leave (_name, _begin, _depth, _allocs);
+            return;
+        }
+
+        perf::sample delta = perf::read ();
+        for (std::size_t c = 0; c < perf::counter_count; ++c)
+            delta[c] -= _start[c];
+        _profiler.leave (_name, _begin, _depth, _allocs, end, delta);
+    }
+
+    cpu_counter_zone (const cpu_counter_zone &other) = delete;
+    cpu_counter_zone & operator= (const cpu_counter_zone &other) = delete;
+
+private:
+    cpu_profiler &_profiler;
+    const char *_name;
+    const std::uint16_t _depth;
+    const bool _sampling;
+    const perf::sample _start;
+    const alloc::counts _allocs;
+    const clock::rep _begin;
 };
 
 const std::string & get_thread_name ();
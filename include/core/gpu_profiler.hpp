@@ -0,0 +1,84 @@
+#ifndef _BLOCKYTRY_CORE_GPU_PROFILER_H_
+#define _BLOCKYTRY_CORE_GPU_PROFILER_H_
+
+#include <cstdint>
+
+#include "cpu_profiler.hpp"
+#include "runtime.hpp"
+
+// -=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+// GPU PROFILING macros
+// -=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+// GPU zones time the GL commands issued inside them with timestamp queries.
+// Like CPU zones they compile away without FOST_PROFILER, and names must be
+// string literals.
+#ifdef FOST_PROFILER
+    #define FOST_GPU_ZONE(name) \
+        const fost::gpu::zone FOST_PROFILE_CONCAT (_fost_gpu_zone_, __LINE__) {name}
+#else
+    #define FOST_GPU_ZONE(name)
+#endif
+
+namespace fost
+{
+namespace gpu
+{
+
+// Frames whose queries may be in flight. Results are read back this many
+// frames late, by which time the GPU is done with them, so reading never
+// stalls the pipeline.
+constexpr std::uint32_t frames_in_flight = 4U;
+
+// Zones per frame, including the frame itself. Extra zones are not timed.
+constexpr std::uint32_t max_zones = 32U;
+
+// Creates the query ring and publishes results to a "GPU" profiler track, in
+// the same timeline as the CPU zones. Needs a current GL 3.3 context. Returns
+// false if the driver has no usable timestamp queries.
+const bool init ();
+
+// Deletes the queries. The context must still be current.
+void shutdown ();
+
+const bool is_available ();
+
+// Brackets the GL work of one frame, which becomes the root zone. begin_frame
+// also reads back the frame issued frames_in_flight frames ago.
+void begin_frame ();
+void end_frame ();
+
+// GPU time between the first and last command of the newest resolved frame.
+const clock::duration last_frame_time ();
+
+// Frames whose results were still not ready when their slot came round again
+// and were dropped instead of waited for.
+const std::uint64_t dropped ();
+
+// Marks a GPU zone. Use through FOST_GPU_ZONE.
+std::uint32_t begin_zone (const char *name);
+void end_zone (const std::uint32_t index);
+
+// RAII GPU zone.
+class zone
+{
+public:
+    explicit zone (const char *name)
+        : _index {begin_zone (name)}
+    {}
+
+    ~zone ()
+    {
+        end_zone (_index);
+    }
+
+    zone (const zone &other) = delete;
+    zone & operator= (const zone &other) = delete;
+
+private:
+    const std::uint32_t _index;
+};
+
+} // namespace gpu
+} // namespace fost
+
+#endif // _BLOCKYTRY_CORE_GPU_PROFILER_H_
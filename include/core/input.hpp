@@ -1,7 +1,11 @@
 #ifndef _BLOCKYTRY_CORE_INPUT_H_
 #define _BLOCKYTRY_CORE_INPUT_H_
 
+#include <algorithm>
+#include <array>
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
 
 #include "runtime.hpp"
 
@@ -14,7 +18,11 @@ class key_event
 {
 public:
     key_event ()
-        : _pressed {fost::clock::now ()}
+        : key_event {fost::clock::now ()}
+    {}
+
+    explicit key_event (const fost::clock::time_point pressed)
+        : _pressed {pressed}
         , _released {_pressed}
     {}
 
@@ -41,9 +49,10 @@ public:
         return std::chrono::duration_cast <_Unit> (fost::clock::now () - _pressed);
     }
 
+    // Counted at the tick rate active now.
     inline const auto ticks_elapsed () const
     {
-        return (time_elapsed () / fost::runtime::mspt);
+        return (time_elapsed <fost::clock::duration> () / fost::runtime::tick_interval ());
     }
 
     template <class _Unit = std::chrono::milliseconds>
@@ -56,25 +65,291 @@ public:
     inline const auto ticks_held () const
     {
         assert (is_complete ());
-        return (time_held () / fost::runtime::mspt);
+        return (time_held <fost::clock::duration> () / fost::runtime::tick_interval ());
     }
 
 private:
-    // TODO: Friend input system class/function, not this global one.
-    friend void key_callback (GLFWwindow*, int, int, int, int);
+    friend class key_ring;
 
     fost::clock::time_point _pressed;
     fost::clock::time_point _released;
 
-    inline void complete ()
+    inline void complete (const fost::clock::time_point released)
     {
         assert (_released == _pressed);
-        _released = fost::clock::now ();
+        // Never equal to the press, or the event would not count as complete.
+        _released = std::max (released, _pressed + fost::clock::duration {1});
+    }
+};
+
+// Scancodes at or above this are ignored.
+constexpr std::size_t max_keys = 256U;
+// Presses kept per key between prune ()s. A key pressed more often than this
+// within one tick loses its oldest presses.
+constexpr std::size_t key_ring_capacity = 8U;
+
+// One bit per scancode. The operators work a word at a time, which compilers
+// turn into a few vector instructions.
+struct key_mask
+{
+    std::array <std::uint64_t, max_keys / 64U> words {};
+
+    inline const bool test (const int scancode) const
+    {
+        return (scancode >= 0 && static_cast <std::size_t> (scancode) < max_keys)
+            && ((words[scancode / 64] >> (scancode % 64)) & 1U);
+    }
+
+    inline void set (const int scancode)
+    {
+        words[scancode / 64] |= (std::uint64_t {1} << (scancode % 64));
+    }
+
+    inline void reset (const int scancode)
+    {
+        words[scancode / 64] &= ~(std::uint64_t {1} << (scancode % 64));
+    }
+
+    inline const bool any () const
+    {
+        std::uint64_t bits = 0U;
+        for (const std::uint64_t word : words)
+            bits |= word;
+        return (bits != 0U);
+    }
+
+    inline friend const key_mask operator& (const key_mask &a, const key_mask &b)
+    {
+        key_mask result;
+        for (std::size_t i = 0U; i < result.words.size (); ++i)
+            result.words[i] = a.words[i] & b.words[i];
+        return result;
+    }
+
+    inline friend const key_mask operator| (const key_mask &a, const key_mask &b)
+    {
+        key_mask result;
+        for (std::size_t i = 0U; i < result.words.size (); ++i)
+            result.words[i] = a.words[i] | b.words[i];
+        return result;
+    }
+
+    inline friend const key_mask operator~ (const key_mask &a)
+    {
+        key_mask result;
+        for (std::size_t i = 0U; i < result.words.size (); ++i)
+            result.words[i] = ~a.words[i];
+        return result;
+    }
+
+    inline friend bool operator== (const key_mask &a, const key_mask &b) = default;
+};
+
+// The presses of one key since it was last pruned, oldest first. Fixed size,
+// so recording a press never allocates. Only back () can be incomplete.
+class key_ring
+{
+public:
+    key_ring () = default;
+
+    inline const std::size_t size () const
+    {
+        return _size;
+    }
+
+    inline const bool empty () const
+    {
+        return (_size == 0U);
+    }
+
+    inline const key_event & operator[] (const std::size_t i) const
+    {
+        assert (i < _size);
+        return _events[(_head + i) % key_ring_capacity];
+    }
+
+    inline const key_event & front () const
+    {
+        return (*this)[0U];
+    }
+
+    inline const key_event & back () const
+    {
+        return (*this)[_size - 1U];
+    }
+
+    inline void push (const fost::clock::time_point pressed)
+    {
+        if (_size == key_ring_capacity)
+            pop_front ();
+        _events[(_head + _size++) % key_ring_capacity] = key_event {pressed};
+    }
+
+    // Records the release of the latest press. A release without a press,
+    // of a key held down before the window had focus, is ignored.
+    inline void complete (const fost::clock::time_point released)
+    {
+        if (! empty () && ! back ().is_complete ())
+            _events[(_head + _size - 1U) % key_ring_capacity].complete (released);
+    }
+
+    inline void pop_front ()
+    {
+        assert (_size != 0U);
+        _head = (_head + 1U) % key_ring_capacity;
+        --_size;
+    }
+
+    inline void pop_back ()
+    {
+        assert (_size != 0U);
+        --_size;
+    }
+
+    // Drops every complete press, keeping a press still held.
+    inline void prune ()
+    {
+        if (_size == 0U)
+            return;
+        if (! back ().is_complete ())
+        {
+            _head = (_head + _size - 1U) % key_ring_capacity;
+            _size = 1U;
+        }
+        else
+            _size = 0U;
+    }
+
+private:
+    std::array <key_event, key_ring_capacity> _events {};
+    std::uint8_t _head = 0U;
+    std::uint8_t _size = 0U;
+};
+
+// Key state of the window, by scancode. Not thread safe, the simulation
+// thread records and reads it.
+
+// Record a press or release at the time it happened.
+void press (const int scancode, const fost::clock::time_point time = fost::clock::now ());
+void release (const int scancode, const fost::clock::time_point time = fost::clock::now ());
+
+// Drops presses released since the last prune (). Call once at the end of
+// every tick.
+void prune ();
+
+// What one tick saw of the keys, 96 bytes. This is the whole per-tick record
+// for replays and network sends: sample () rebuilds the same snapshots from
+// the records of a run.
+struct key_record
+{
+    // Down at any time since the previous record, so a key tapped between
+    // two ticks still shows for one.
+    key_mask current;
+    // Pressed, or released, at least once since the previous record. Kept
+    // apart from current, which cannot tell a key held down throughout from
+    // one released and pressed again.
+    key_mask pressed;
+    key_mask released;
+};
+
+// Which keys went down and up between two ticks, as masks so a query is one
+// bit test.
+struct key_snapshot
+{
+    key_mask current;
+    key_mask pressed;
+    key_mask released;
+    // Down in this snapshot and in the previous one.
+    key_mask held;
+
+    inline const key_record record () const
+    {
+        return {current, pressed, released};
     }
 };
 
+// Takes the snapshot for a new tick, from the keys recorded since the last
+// one or from a recorded tick. Call once at the start of every tick. The
+// queries below read only what this leaves behind, they never ask the clock.
+void sample ();
+void sample (const key_record &record);
+
+namespace detail
+{
+
+inline std::array <key_ring, max_keys> s_keys {};
+inline key_snapshot s_snapshot {};
+// Whole ticks each key has been held down for, counted by sample ().
+inline std::array <long, max_keys> s_held {};
+// Keys down at the previous sample (), whose oldest press is from before
+// this tick.
+inline key_mask s_carried {};
+
+inline const bool is_valid (const int scancode)
+{
+    return (scancode >= 0 && static_cast <std::size_t> (scancode) < max_keys);
+}
+
+} // namespace detail
+
+inline const key_snapshot & snapshot ()
+{
+    return detail::s_snapshot;
+}
+
+inline const key_ring & events (const int scancode)
+{
+    static const key_ring none {};
+    return detail::is_valid (scancode) ? detail::s_keys[scancode] : none;
+}
+
+// Like events (), without a press still held.
+inline const key_ring complete_events (const int scancode)
+{
+    key_ring complete = events (scancode);
+    if (! complete.empty () && ! complete.back ().is_complete ())
+        complete.pop_back ();
+    return complete;
+}
+
+// Presses since the last tick, not counting one still held from before.
+inline const int key_down (const int scancode)
+{
+    const std::size_t count = events (scancode).size ();
+    return static_cast <int> ((count > 0U && detail::s_carried.test (scancode)) ? count - 1U : count);
+}
+
+// Releases since the last tick.
+inline const int key_up (const int scancode)
+{
+    const key_ring &ring = events (scancode);
+    const std::size_t count = ring.size ();
+    return static_cast <int> ((count > 0U && ! ring.back ().is_complete ()) ? count - 1U : count);
+}
+
+// Whole ticks the key has been held for, 0 when it is up or was pressed
+// again this tick.
+inline const long key_held (const int scancode)
+{
+    return detail::is_valid (scancode) ? detail::s_held[scancode] : 0L;
+}
+
+inline const bool is_pressed (const int scancode)
+{
+    return snapshot ().pressed.test (scancode);
+}
+
+inline const bool is_released (const int scancode)
+{
+    return snapshot ().released.test (scancode);
+}
+
+inline const bool is_down (const int scancode)
+{
+    return snapshot ().current.test (scancode);
+}
+
 } // namespace input
 } // namespace fost
 
-
 #endif // _BLOCKYTRY_CORE_INPUT_H_
\ No newline at end of file
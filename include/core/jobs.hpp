@@ -0,0 +1,138 @@
+#ifndef _BLOCKYTRY_CORE_JOBS_H_
+#define _BLOCKYTRY_CORE_JOBS_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace fost
+{
+namespace jobs
+{
+
+// Work-stealing job system. The thread calling init () becomes worker 0 and
+// one more worker is started per remaining core. Every worker owns a
+// Chase-Lev deque: it pushes and pops its own jobs at the bottom while idle
+// workers steal from the top of the others.
+//
+// Jobs may be submitted from any worker, including from inside jobs, but not
+// from threads outside the system. Each worker hands out jobs from its own
+// ring of job_pool_size slots. A worker that wraps around onto a slot whose
+// job has not run yet runs other jobs until it has, rather than overwrite it.
+
+// Jobs buffered per worker deque. A job that does not fit runs inline.
+constexpr std::size_t deque_capacity = 1U << 12;
+
+// Job slots per worker, reused round robin.
+constexpr std::size_t job_pool_size = 1U << 12;
+
+// Bytes of closure a job can hold, so that a job fills one cache line.
+constexpr std::size_t job_storage = 32U;
+
+struct job;
+
+// Counts unfinished jobs. Pass the same counter to several run () calls and
+// wait () on it to join them all.
+class counter
+{
+public:
+    counter () = default;
+
+    counter (const counter &other) = delete;
+    counter & operator= (const counter &other) = delete;
+
+    inline const bool done () const
+    {
+        return (_pending.load (std::memory_order_acquire) == 0U);
+    }
+
+private:
+    friend struct job;
+    friend void submit (job &j, counter &c);
+
+    std::atomic <std::uint32_t> _pending {0U};
+};
+
+struct alignas (64) job
+{
+    void (*invoke) (job &self);
+    counter *done;
+    // Submitted and not run yet, the slot must not be handed out again.
+    std::atomic <bool> pending {false};
+    alignas (std::max_align_t) unsigned char storage[job_storage];
+
+    // Runs the job and releases whoever waits on its counter.
+    inline void execute ()
+    {
+        counter &c = *done;
+        invoke (*this);
+        pending.store (false, std::memory_order_release);
+        c._pending.fetch_sub (1U, std::memory_order_release);
+    }
+};
+
+static_assert (sizeof (job) == 64U, "job should fill one cache line");
+
+// Starts worker_count - 1 threads; 0 picks one worker per hardware thread.
+void init (std::size_t worker_count = 0U);
+
+// Joins the workers. Jobs still queued are dropped, wait for them first.
+void shutdown ();
+
+// Number of workers including the thread that called init (), 0 before init.
+const std::size_t worker_count ();
+
+// Index of the calling worker, or -1 on a thread outside the job system.
+const int this_worker ();
+
+// Next free job slot of the calling worker.
+job & allocate ();
+
+// Queues a filled job on the calling worker's deque and counts it in c.
+void submit (job &j, counter &c);
+
+// Runs other jobs until c drops to zero, so waiting never idles a worker.
+void wait (const counter &c);
+
+// Queues fn () to run on any worker.
+template <class _Fn>
+void run (counter &c, _Fn &&fn)
+{
+    using closure = std::decay_t <_Fn>;
+    static_assert (sizeof (closure) <= job_storage, "job closure too large, capture less or by reference");
+    static_assert (alignof (closure) <= alignof (std::max_align_t), "job closure over-aligned");
+
+    job &j = allocate ();
+    ::new (static_cast <void*> (j.storage)) closure {std::forward <_Fn> (fn)};
+    j.invoke = [] (job &self)
+    {
+        closure &f = *std::launder (reinterpret_cast <closure*> (self.storage));
+        f ();
+        f.~closure ();
+    };
+    submit (j, c);
+}
+
+// Calls fn (begin, end) over [0, count) in slices of at most grain items,
+// spread over the workers, and returns once all are done.
+template <class _Fn>
+void parallel_for (const std::size_t count, const std::size_t grain, _Fn &&fn)
+{
+    counter c;
+    const std::size_t step = std::max <std::size_t> (grain, 1U);
+    for (std::size_t begin = 0U; begin < count; begin += step)
+    {
+        const std::size_t end = std::min (begin + step, count);
+        run (c, [&fn, begin, end] () { fn (begin, end); });
+    }
+    wait (c);
+}
+
+} // namespace jobs
+} // namespace fost
+
+#endif // _BLOCKYTRY_CORE_JOBS_H_
@@ -0,0 +1,48 @@
+#ifndef _BLOCKYTRY_CORE_PERF_COUNTERS_H_
+#define _BLOCKYTRY_CORE_PERF_COUNTERS_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace fost
+{
+namespace perf
+{
+
+// Hardware events sampled for counter zones.
+enum counter : std::size_t
+{
+    cycles = 0,
+    instructions,
+    cache_misses,   // Last level cache misses.
+    branch_misses,
+    counter_count
+};
+
+using sample = std::array <std::uint64_t, counter_count>;
+
+// Counters are off until enabled. Enabling opens a perf_event_open group per
+// thread on its first read. Linux only.
+void set_enabled (const bool enabled);
+const bool is_enabled ();
+
+// True if the calling thread's counter group is open. Perf events are often
+// unavailable in containers, VMs or with a high kernel.perf_event_paranoid;
+// the first failure is reported once and counters stay off from then on.
+const bool available ();
+
+// Current counter values of the calling thread, or zeros when unavailable.
+// Events the CPU does not support read as zero too.
+const sample read ();
+
+// Instructions per cycle over a delta sample, 0 if no cycles were counted.
+inline double ipc (const sample &delta)
+{
+    return delta[cycles] ? static_cast <double> (delta[instructions]) / delta[cycles] : 0.0;
+}
+
+} // namespace perf
+} // namespace fost
+
+#endif // _BLOCKYTRY_CORE_PERF_COUNTERS_H_
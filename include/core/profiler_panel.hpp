@@ -0,0 +1,37 @@
+#ifndef _BLOCKYTRY_CORE_PROFILER_PANEL_H_
+#define _BLOCKYTRY_CORE_PROFILER_PANEL_H_
+
+#include "alloc_tracker.hpp"
+#include "runtime.hpp"
+
+namespace fost
+{
+namespace profiler_panel
+{
+
+// Frames and ticks kept in the scrolling histories.
+constexpr int history_size = 512;
+
+// Zones kept for the flame graph of the last complete frame.
+constexpr int flame_capacity = 1024;
+
+// Adds one frame time to the history.
+void record_frame (const clock::duration frame_time);
+
+// Adds one tick time to the history.
+void record_tick (const clock::duration tick_time);
+
+// Adds the heap activity of one frame, see alloc::since. Only shown when
+// built with BLOCKYTRY_TRACK_ALLOCATIONS.
+void record_allocations (const alloc::counts &frame);
+
+// Draws the debug-HUD profiler window: frame and tick histories and a flame
+// graph of the calling thread's last complete "frame" zone. Call between
+// ImGui::NewFrame and ImGui::Render. All buffers are preallocated, so drawing
+// allocates nothing beyond what ImGui itself does.
+void draw ();
+
+} // namespace profiler_panel
+} // namespace fost
+
+#endif // _BLOCKYTRY_CORE_PROFILER_PANEL_H_
@@ -0,0 +1,50 @@
+#ifndef _BLOCKYTRY_CORE_PROFILER_STREAM_H_
+#define _BLOCKYTRY_CORE_PROFILER_STREAM_H_
+
+#include <cstdint>
+#include <string>
+
+#include "alloc_tracker.hpp"
+#include "runtime.hpp"
+
+namespace fost
+{
+namespace stream
+{
+
+// Socket path used when none is given: $XDG_RUNTIME_DIR/blockytry-profiler.sock,
+// or under /tmp when that is not set.
+const std::string default_socket_path ();
+
+// Listens on a Unix domain socket at path. A background thread sends frame,
+// tick and zone records to one viewer at a time, using the capture chunk
+// format (see capture_format.hpp). Returns false if the socket could not be
+// created or sockets are not supported on this platform. A socket file left
+// behind by a crashed run is replaced; anything else at path, including the
+// live socket of another instance, is left alone and makes start () fail.
+const bool start (const std::string &path);
+
+// Disconnects the viewer, stops listening and removes the socket file.
+void stop ();
+
+const bool is_listening ();
+const bool is_connected ();
+
+// The recorders below never block and take no locks. While no viewer is
+// connected they return immediately; otherwise records go to a bounded queue
+// and the oldest ones are dropped when the viewer falls behind. Call them all
+// from one thread.
+void record_frame (const clock::time_point begin, const clock::duration duration, const std::uint32_t ticks,
+                   const alloc::counts &allocations);
+void record_tick (const clock::time_point begin, const clock::duration duration);
+
+// Queues zones published since the last call. Call once per frame from one thread.
+void collect_zones ();
+
+// Records dropped because the viewer was too slow, since start ().
+const std::uint64_t dropped ();
+
+} // namespace stream
+} // namespace fost
+
+#endif // _BLOCKYTRY_CORE_PROFILER_STREAM_H_
@@ -0,0 +1,66 @@
+#ifndef _BLOCKYTRY_CORE_QUALITY_H_
+#define _BLOCKYTRY_CORE_QUALITY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+#include "runtime.hpp"
+
+namespace fost
+{
+namespace quality
+{
+
+// Trades quality for frame time. Subsystems register knobs, each a setting
+// with a few levels from 0 (cheapest) up; update () watches frame work times
+// and tick load and turns knobs down when the target frame time is missed, and
+// back up once there is room again.
+//
+// Register knobs and call everything here from the render thread.
+
+using knob_id = std::uint32_t;
+
+// Called with the new level whenever the governor, or set_level (), moves
+// the knob. Also called once from add_knob () with the initial level.
+using apply_fn = std::function <void (const std::uint32_t level)>;
+
+// Knobs with the lowest priority are turned down first and up last. Name
+// must be a string literal.
+knob_id add_knob (const char *name, const std::uint32_t levels, const std::uint32_t initial,
+                  const int priority, apply_fn apply);
+
+// Moves a knob by hand, clamped to its levels. The governor may move it
+// again later.
+void set_level (const knob_id id, const std::uint32_t level);
+
+struct knob_info
+{
+    const char *name;
+    std::uint32_t levels;
+    std::uint32_t level;
+    int priority;
+};
+
+const std::size_t knob_count ();
+const knob_info knob (const knob_id id);
+
+// Frame time to hold, zero turns the governor off.
+void set_target_frame_time (const clock::duration target);
+const clock::duration target_frame_time ();
+
+// Feeds the work time of the last frame and adjusts at most one knob. Call
+// once per frame. Measure from after runtime::pace_frame () to before the
+// buffer swap: time spent waiting on the frame cap or vsync is not load, and
+// counting it would turn every knob down for good.
+void update (const clock::duration work);
+
+// Latest measured load against the target: the 95th percentile frame work
+// time over the target, or the tick load over the tick budget if higher. Above
+// 1 means over budget.
+const float pressure ();
+
+} // namespace quality
+} // namespace fost
+
+#endif // _BLOCKYTRY_CORE_QUALITY_H_
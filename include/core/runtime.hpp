@@ -1,8 +1,11 @@
 #ifndef _BLOCKYTRY_CORE_RUNTIME_H_
 #define _BLOCKYTRY_CORE_RUNTIME_H_
 
+#include <atomic>
 #include <chrono>
+#include <compare>
 #include <cstddef>
+#include <cstdint>
 
 using namespace std::chrono_literals;
 
@@ -23,20 +26,104 @@ using clock = std::chrono::steady_clock;
 namespace runtime
 {
 
-// Ticks per second - how many ticks happen in 1 second.
-// 50 milliseconds per tick. 1/50 = 0.02 ticks per millisecond = 20 tps.
-constexpr std::uint16_t tps = 20U;
+using duration = clock::duration;
+using time_point = std::chrono::time_point <clock, duration>;
+constexpr duration zero = duration{0};
+
+// Ticks per second the program starts with, 50 milliseconds per tick.
+constexpr std::uint16_t default_tps = 20U;
+
+// Range set_tps () accepts.
+constexpr std::uint16_t min_tps = 1U;
+constexpr std::uint16_t max_tps = 1000U;
+
+// A number of ticks. The tick rate can change while running, so ticks have
+// no fixed period and do not mix with durations; convert with to_duration ()
+// and to_ticks (). Costs no more than the integer it holds.
+class ticks
+{
+public:
+    using rep = std::int64_t;
+
+    constexpr ticks () = default;
+    constexpr explicit ticks (const rep count) : _count {count} {}
+
+    constexpr rep count () const
+    {
+        return _count;
+    }
+
+    constexpr ticks & operator+= (const ticks other)
+    {
+        _count += other._count;
+        return *this;
+    }
+
+    constexpr ticks & operator-= (const ticks other)
+    {
+        _count -= other._count;
+        return *this;
+    }
 
-// Milliseconds per tick - interval at which most game systems are ticked.
-// 20 ticks per second. 1/20 = 0.05 seconds per tick = 50 mspt.
-constexpr std::chrono::milliseconds mspt = 1000ms / tps;
+    friend constexpr ticks operator+ (ticks lhs, const ticks rhs)
+    {
+        return (lhs += rhs);
+    }
+
+    friend constexpr ticks operator- (ticks lhs, const ticks rhs)
+    {
+        return (lhs -= rhs);
+    }
+
+    friend constexpr auto operator<=> (const ticks lhs, const ticks rhs) = default;
+
+private:
+    rep _count = 0;
+};
 
-using ticks = std::chrono::duration <std::int64_t, std::ratio <1, tps>>;
 constexpr ticks tick_unit = ticks{1};
 
-using duration = decltype (clock::duration {} + tick_unit);
-using time_point = std::chrono::time_point <clock, duration>;
-constexpr duration zero = duration{0};
+namespace detail
+{
+
+// Read on every tick from several threads, so kept apart from other data.
+alignas (64) inline std::atomic <std::uint16_t> s_tps {default_tps};
+alignas (64) inline std::atomic <duration::rep> s_tick_interval {(duration {1s} / default_tps).count ()};
+
+} // namespace detail
+
+// Ticks per second - how many ticks happen in 1 second.
+inline const std::uint16_t tps ()
+{
+    return detail::s_tps.load (std::memory_order_relaxed);
+}
+
+// Length of one tick at the current rate.
+inline const duration tick_interval ()
+{
+    return duration {detail::s_tick_interval.load (std::memory_order_relaxed)};
+}
+
+// Milliseconds per tick, rounded down. Use tick_interval () for arithmetic.
+inline const std::chrono::milliseconds mspt ()
+{
+    return std::chrono::duration_cast <std::chrono::milliseconds> (tick_interval ());
+}
+
+inline const duration to_duration (const ticks t)
+{
+    return t.count () * tick_interval ();
+}
+
+// Whole ticks in d, rounded down.
+inline const ticks to_ticks (const duration d)
+{
+    return ticks {d / tick_interval ()};
+}
+
+// Changes the tick rate, clamped to [min_tps, max_tps]. Safe from any thread;
+// the simulation picks it up from its next tick on.
+void set_tps (const std::uint16_t rate);
 
 // Called each frame to update its delta time.
 void cycle ();
@@ -59,6 +146,60 @@ const duration frame_time ();
 // Frames per second.
 const float fps ();
 
+// Frame time distribution over a window of recent frames.
+struct frame_stats
+{
+    duration p50;
+    duration p95;
+    duration p99;
+    duration p999;
+    // Average fps of the slowest 1% of frames.
+    float low_1_percent_fps;
+    // Frames the statistics were taken over.
+    std::size_t frames;
+};
+
+// Windows tracked by cycle (). Both are sized in frames and can be changed.
+enum class stats_window : std::size_t
+{
+    recent = 0,     // 256 frames by default
+    sustained = 1,  // 8192 frames by default
+};
+
+// Longest window that can be tracked, in frames.
+constexpr std::size_t max_stats_window = 1U << 14;
+
+// Resizes a window, clamped to [1, max_stats_window]. Takes effect at once,
+// over the frames already recorded.
+void set_stats_window (const stats_window window, const std::size_t frames);
+
+// Percentiles are bucketed with about 3% relative precision.
+const frame_stats frame_percentiles (const stats_window window = stats_window::recent);
+
+// Caps the frame rate; 0 turns the cap off. Frames are started on a fixed
+// grid of 1 / fps, without vsync and without a core spinning at full tilt.
+void set_frame_cap (const float fps);
+const float frame_cap ();
+
+// Waits until the next frame is due: sleeps most of the way, then spins on
+// fost::clock for the last stretch, which sleep overshoots. Call once per
+// frame before cycle (). Does nothing without a cap.
+void pace_frame ();
+
+// How far frame starts land from their slot on the grid. Late frames count
+// too; when a frame is over a whole interval late the grid starts again.
+struct pacing_stats
+{
+    duration last;
+    // Mean and worst over the recent frames.
+    duration mean;
+    duration worst;
+    // How early the pacer currently wakes up to spin, see pace_frame.
+    duration spin;
+};
+
+const pacing_stats pacing_error ();
+
 } // namespace runtime
 } // namespace fost
 
@@ -0,0 +1,51 @@
+#ifndef _BLOCKYTRY_CORE_SAMPLER_H_
+#define _BLOCKYTRY_CORE_SAMPLER_H_
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace fost
+{
+namespace sampler
+{
+
+// Statistical CPU sampler. Every registered thread gets a timer on its own CPU
+// clock that raises SIGPROF each interval of CPU time it consumes; the signal
+// handler walks the interrupted call stack by its frame pointers into a
+// preallocated per-thread ring. Code built without frame pointers shows up
+// with callers missing. Unlike profiler zones this also sees third party code (glad, imgui,
+// the GL driver). Linux only, elsewhere start () returns false.
+
+// Installs the signal handler and registers the calling thread. Returns false
+// if sampling is not supported or the handler could not be installed.
+const bool start (const std::chrono::microseconds interval = std::chrono::microseconds {1000});
+
+// Stops every thread's timer. Samples already taken are kept for write_folded.
+void stop ();
+
+const bool is_running ();
+
+// Starts sampling the calling thread, named after get_thread_name () in the
+// output. No-op if the sampler is not running or the thread is registered.
+// Threads are unregistered automatically when they exit.
+void register_thread ();
+
+// Moves new samples out of the rings into the aggregated stacks, so rings do
+// not wrap in long sessions. Call periodically, e.g. once per frame.
+void collect ();
+
+// Samples taken and samples lost to full rings, since start ().
+const std::uint64_t samples ();
+const std::uint64_t dropped ();
+
+// Symbolizes the aggregated stacks and writes them in the folded format read
+// by flamegraph.pl, speedscope and friends: one "thread;root;...;leaf count"
+// line per unique stack. Slow, call at shutdown. Returns false if path could
+// not be written.
+const bool write_folded (const std::string &path);
+
+} // namespace sampler
+} // namespace fost
+
+#endif // _BLOCKYTRY_CORE_SAMPLER_H_
@@ -0,0 +1,78 @@
+#ifndef _BLOCKYTRY_CORE_SPSC_QUEUE_H_
+#define _BLOCKYTRY_CORE_SPSC_QUEUE_H_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace fost
+{
+
+// Passes entries in order from one producer thread to one consumer thread
+// without locks. Both sides finish in a bounded number of steps: a full queue
+// refuses the push and an empty one the pop, neither waits.
+template <class _Entry, std::size_t _Capacity>
+class spsc_queue
+{
+    static_assert (_Capacity >= 2U && (_Capacity & (_Capacity - 1U)) == 0U,
+                   "spsc_queue capacity must be a power of two");
+
+public:
+    spsc_queue () = default;
+
+    spsc_queue (const spsc_queue &other) = delete;
+    spsc_queue & operator= (const spsc_queue &other) = delete;
+
+    // Producer only. Returns false, and drops nothing already queued, when
+    // the queue is full.
+    inline const bool try_push (const _Entry &entry)
+    {
+        const std::size_t tail = _tail.load (std::memory_order_relaxed);
+        if (tail - _head_seen == _Capacity)
+        {
+            _head_seen = _head.load (std::memory_order_acquire);
+            if (tail - _head_seen == _Capacity)
+                return false;
+        }
+
+        _slots[tail & index_mask] = entry;
+        _tail.store (tail + 1U, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only. Returns false when the queue is empty.
+    inline const bool try_pop (_Entry &entry)
+    {
+        const std::size_t head = _head.load (std::memory_order_relaxed);
+        if (head == _tail_seen)
+        {
+            _tail_seen = _tail.load (std::memory_order_acquire);
+            if (head == _tail_seen)
+                return false;
+        }
+
+        entry = _slots[head & index_mask];
+        _head.store (head + 1U, std::memory_order_release);
+        return true;
+    }
+
+    static constexpr std::size_t capacity ()
+    {
+        return _Capacity;
+    }
+
+private:
+    static constexpr std::size_t index_mask = _Capacity - 1U;
+
+    std::array <_Entry, _Capacity> _slots {};
+    // Each side caches the other's index and only reloads it when the cached
+    // one says full or empty.
+    alignas (64) std::atomic <std::size_t> _tail {0U};
+    std::size_t _head_seen = 0U;
+    alignas (64) std::atomic <std::size_t> _head {0U};
+    std::size_t _tail_seen = 0U;
+};
+
+} // namespace fost
+
+#endif // _BLOCKYTRY_CORE_SPSC_QUEUE_H_
@@ -0,0 +1,84 @@
+#ifndef _BLOCKYTRY_CORE_TASK_GRAPH_H_
+#define _BLOCKYTRY_CORE_TASK_GRAPH_H_
+
+#include <atomic>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <ostream>
+#include <vector>
+
+#include "jobs.hpp"
+
+namespace fost
+{
+
+// Resources are small ids picked by the game, e.g. an enum of shared state.
+constexpr std::size_t max_resources = 64U;
+using resource_set = std::bitset <max_resources>;
+
+// Systems of one tick and the resources they touch. Two systems conflict if
+// one writes what the other reads or writes; conflicting systems run in the
+// order they were added, all others may run in parallel on fost::jobs.
+//
+// Add every system, compile () once, then run () every tick. The schedule is
+// fixed by compile (), so running costs no allocation or analysis.
+class task_graph
+{
+public:
+    using system_fn = std::function <void ()>;
+
+    task_graph () = default;
+
+    task_graph (const task_graph &other) = delete;
+    task_graph & operator= (const task_graph &other) = delete;
+
+    // Name must be a string literal, it also names the counter zone (see
+    // FOST_PROFILE_ZONE_COUNTERS) the system runs in.
+    void add (const char *name, std::initializer_list <std::size_t> reads,
+              std::initializer_list <std::size_t> writes, system_fn fn);
+
+    // Validates the systems and builds the dependency edges. Prints what is
+    // wrong and returns false if the graph cannot run.
+    const bool compile ();
+
+    // Runs every system once and returns when all are done. Without job
+    // workers, systems run one by one in the order they were added.
+    void run ();
+
+    inline const bool is_compiled () const
+    {
+        return _compiled;
+    }
+
+    // Writes each system with the systems it waits for.
+    void describe (std::ostream &os) const;
+
+private:
+    struct system
+    {
+        const char *name;
+        resource_set reads;
+        resource_set writes;
+        system_fn fn;
+        std::vector <std::uint32_t> successors;
+        std::vector <std::uint32_t> predecessors;
+        bool valid;
+    };
+
+    void submit (const std::uint32_t index, jobs::counter &done);
+    void execute (const std::uint32_t index, jobs::counter &done);
+
+    std::vector <system> _systems;
+    std::vector <std::uint32_t> _roots;
+    // Predecessors left to finish this tick, per system.
+    std::unique_ptr <std::atomic <std::uint32_t>[]> _remaining;
+    bool _compiled = false;
+};
+
+} // namespace fost
+
+#endif // _BLOCKYTRY_CORE_TASK_GRAPH_H_
@@ -0,0 +1,98 @@
+#ifndef _BLOCKYTRY_CORE_TICK_GOVERNOR_H_
+#define _BLOCKYTRY_CORE_TICK_GOVERNOR_H_
+
+#include <cstdint>
+#include <functional>
+
+#include "runtime.hpp"
+
+namespace fost
+{
+namespace runtime
+{
+
+// Decides when each tick runs and what happens when ticks fall behind real
+// time, and measures every tick against its budget. Drives one simulation
+// loop:
+//
+//     while (running)
+//     {
+//         const auto slot = fost::runtime::await_tick ();
+//         const auto begin = fost::clock::now ();
+//         tick ();
+//         fost::runtime::end_tick (begin, fost::clock::now () - begin);
+//     }
+
+// What to do when a tick comes due late.
+enum class overrun_policy : std::uint8_t
+{
+    // Run late ticks back to back, up to max_catch_up of them. Time further
+    // behind than that is dropped.
+    catch_up = 0,
+    // Never run ticks back to back, the simulation slows down instead.
+    dilate,
+    // Drop every tick slot already missed and carry on from the latest.
+    skip,
+};
+
+struct governor_config
+{
+    overrun_policy policy = overrun_policy::catch_up;
+    // Ticks catch_up may run back to back; 5 is 250 ms at 20 tps.
+    std::uint32_t max_catch_up = 5U;
+    // Share of the tick interval a tick may take before it is over budget.
+    float budget = 1.0f;
+    // Ticks over budget in a row before the simulation counts as
+    // overloaded, and within budget in a row before it recovers.
+    std::uint32_t overload_after = 20U;
+    // Unpaced, ticks run back to back as fast as possible and only the
+    // budget is watched.
+    bool paced = true;
+};
+
+struct tick_stats
+{
+    std::uint64_t ticks;
+    std::uint64_t over_budget;
+    // Tick slots dropped by catch_up and skip.
+    std::uint64_t skipped;
+    // Real time not simulated, dropped or dilated away.
+    duration lost;
+    duration last;
+    // Moving average of tick durations, and of it over the tick interval.
+    duration mean;
+    float load;
+    // Moving average of simulated over real time, below 1 when dilating and
+    // above it when catching up.
+    float time_scale;
+    // Whole ticks the latest one was late by.
+    std::uint32_t behind;
+    bool overloaded;
+};
+
+using governor_callback = std::function <void (const tick_stats &stats)>;
+
+// Safe from any thread, used from the next tick on.
+void configure_governor (const governor_config &config);
+const governor_config governor ();
+
+// Set before the simulation starts. Called on the simulation thread, from
+// end_tick (), with the stats as they are after that tick.
+void on_tick_overrun (governor_callback callback);
+void on_overload (governor_callback callback);
+void on_recover (governor_callback callback);
+
+// Sleeps until the next tick is due and applies the overrun policy if it is
+// late. Returns the time slot of the tick to run.
+const clock::time_point await_tick ();
+
+// Reports a finished tick.
+void end_tick (const clock::time_point begin, const clock::duration took);
+
+// Safe from any thread.
+const tick_stats tick_statistics ();
+
+} // namespace runtime
+} // namespace fost
+
+#endif // _BLOCKYTRY_CORE_TICK_GOVERNOR_H_
@@ -0,0 +1,225 @@
+#ifndef _BLOCKYTRY_CORE_TIMER_WHEEL_H_
+#define _BLOCKYTRY_CORE_TIMER_WHEEL_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "runtime.hpp"
+
+namespace fost
+{
+
+// Hierarchical timer wheel counting in ticks, after Varghese and Lauck,
+// "Hashed and Hierarchical Timing Wheels" (1987). Level 0 has one slot per
+// tick for the next 64 ticks, each level above covers 64 times the span of
+// the one below. Timers drop a level whenever the level below wraps, so
+// schedule (), cancel () and advance () are O(1) however many timers wait:
+// a timer is moved at most once per level in its whole life.
+//
+// _Entry is what a timer carries, e.g. std::function <void ()> or a handle.
+// It must be default constructible and movable. Not thread safe.
+template <class _Entry>
+class timer_wheel
+{
+public:
+    // Names a scheduled timer. Stays safe to cancel after the timer fired or
+    // its slot got reused.
+    struct handle
+    {
+        std::uint32_t index = 0U;
+        std::uint32_t generation = 0U;
+    };
+
+    // Bits of delay resolved per level.
+    static constexpr std::uint32_t slot_bits = 6U;
+    static constexpr std::uint32_t slots = 1U << slot_bits;
+    static constexpr std::uint32_t levels = 6U;
+
+    // Longer delays are clamped, about 108 years at 20 tps.
+    static constexpr std::int64_t max_delay = (std::int64_t {1} << (slot_bits * levels)) - 1;
+
+    timer_wheel ()
+    {
+        _heads.fill (nil);
+    }
+
+    timer_wheel (const timer_wheel &other) = delete;
+    timer_wheel & operator= (const timer_wheel &other) = delete;
+
+    // Fires entry on the advance () delay ticks from now. Delays below one
+    // tick fire on the next advance ().
+    handle schedule (const runtime::ticks delay, _Entry entry)
+    {
+        std::uint32_t index;
+        if (_free != nil)
+        {
+            index = _free;
+            _free = _nodes[index].next;
+        }
+        else
+        {
+            index = static_cast <std::uint32_t> (_nodes.size ());
+            _nodes.emplace_back ();
+        }
+
+        const std::int64_t d = (delay.count () < 1) ? 1 : ((delay.count () > max_delay) ? max_delay : delay.count ());
+        node &n = _nodes[index];
+        n.entry = std::move (entry);
+        n.due = _now + d;
+        link (index);
+        ++_pending;
+        return {index, n.generation};
+    }
+
+    // Drops a timer that has not fired yet. Returns false if it already fired
+    // or was cancelled.
+    const bool cancel (const handle h)
+    {
+        if (! is_pending (h))
+            return false;
+
+        unlink (h.index);
+        release (h.index);
+        return true;
+    }
+
+    const bool is_pending (const handle h) const
+    {
+        return (h.index < _nodes.size () && _nodes[h.index].generation == h.generation
+            && _nodes[h.index].slot != no_slot);
+    }
+
+    // Moves time on by one tick and calls fire (entry) for every timer due,
+    // in no particular order. fire may schedule and cancel timers; new ones
+    // never fire in the same advance ().
+    template <class _Fn>
+    void advance (_Fn &&fire)
+    {
+        ++_now;
+
+        // Pull timers of the next level down when the one below wraps.
+        for (std::uint32_t level = 1U; level < levels; ++level)
+        {
+            const std::uint64_t shift = slot_bits * level;
+            if ((_now & ((std::int64_t {1} << shift) - 1)) != 0)
+                break;
+            cascade (level * slots + static_cast <std::uint32_t> ((_now >> shift) & (slots - 1)));
+        }
+
+        std::uint32_t &head = _heads[static_cast <std::size_t> (_now & (slots - 1))];
+        while (head != nil)
+        {
+            const std::uint32_t index = head;
+            unlink (index);
+            _Entry entry = std::move (_nodes[index].entry);
+            release (index);
+            fire (entry);
+        }
+    }
+
+    // Drops every timer, handing each entry to drop (entry) first.
+    template <class _Fn>
+    void clear (_Fn &&drop)
+    {
+        for (std::uint32_t slot = 0U; slot < slots * levels; ++slot)
+        {
+            while (_heads[slot] != nil)
+            {
+                const std::uint32_t index = _heads[slot];
+                unlink (index);
+                drop (_nodes[index].entry);
+                release (index);
+            }
+        }
+    }
+
+    // Ticks advanced so far.
+    inline const runtime::ticks now () const
+    {
+        return runtime::ticks {_now};
+    }
+
+    // Timers scheduled and not yet fired or cancelled.
+    inline const std::size_t pending () const
+    {
+        return _pending;
+    }
+
+private:
+    static constexpr std::uint32_t nil = ~std::uint32_t {0};
+    static constexpr std::uint16_t no_slot = ~std::uint16_t {0};
+
+    struct node
+    {
+        _Entry entry {};
+        std::int64_t due = 0;
+        std::uint32_t prev = nil;
+        std::uint32_t next = nil;
+        std::uint32_t generation = 1U;
+        std::uint16_t slot = no_slot;
+    };
+
+    // Lowest level whose span covers the delay left, slotted by due tick.
+    void link (const std::uint32_t index)
+    {
+        node &n = _nodes[index];
+        const std::int64_t delta = n.due - _now;
+        std::uint32_t level = 0U;
+        while (level + 1U < levels && delta >= (std::int64_t {1} << (slot_bits * (level + 1U))))
+            ++level;
+
+        n.slot = static_cast <std::uint16_t> (level * slots + ((n.due >> (slot_bits * level)) & (slots - 1)));
+        n.prev = nil;
+        n.next = _heads[n.slot];
+        if (n.next != nil)
+            _nodes[n.next].prev = index;
+        _heads[n.slot] = index;
+    }
+
+    void unlink (const std::uint32_t index)
+    {
+        node &n = _nodes[index];
+        if (n.prev != nil)
+            _nodes[n.prev].next = n.next;
+        else
+            _heads[n.slot] = n.next;
+        if (n.next != nil)
+            _nodes[n.next].prev = n.prev;
+        n.slot = no_slot;
+    }
+
+    void release (const std::uint32_t index)
+    {
+        node &n = _nodes[index];
+        n.entry = _Entry {};
+        ++n.generation;
+        n.next = _free;
+        _free = index;
+        --_pending;
+    }
+
+    void cascade (const std::uint32_t slot)
+    {
+        std::uint32_t index = _heads[slot];
+        _heads[slot] = nil;
+        while (index != nil)
+        {
+            const std::uint32_t next = _nodes[index].next;
+            link (index);
+            index = next;
+        }
+    }
+
+    std::vector <node> _nodes;
+    std::array <std::uint32_t, slots * levels> _heads;
+    std::uint32_t _free = nil;
+    std::int64_t _now = 0;
+    std::size_t _pending = 0U;
+};
+
+} // namespace fost
+
+#endif // _BLOCKYTRY_CORE_TIMER_WHEEL_H_
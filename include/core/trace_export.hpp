@@ -0,0 +1,20 @@
+#ifndef _BLOCKYTRY_CORE_TRACE_EXPORT_H_
+#define _BLOCKYTRY_CORE_TRACE_EXPORT_H_
+
+#include <ostream>
+#include <string>
+
+namespace fost
+{
+
+// Writes every zone still held by the cpu profilers as Chrome trace-event JSON,
+// one track per thread named after fost::set_thread_name. The output opens in
+// chrome://tracing, Perfetto UI and Speedscope.
+void export_chrome_trace (std::ostream &os);
+
+// Same as above, into a file. Returns false if the file could not be written.
+const bool export_chrome_trace (const std::string &path);
+
+} // namespace fost
+
+#endif // _BLOCKYTRY_CORE_TRACE_EXPORT_H_
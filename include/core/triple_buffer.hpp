@@ -0,0 +1,66 @@
+#ifndef _BLOCKYTRY_CORE_TRIPLE_BUFFER_H_
+#define _BLOCKYTRY_CORE_TRIPLE_BUFFER_H_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace fost
+{
+
+// Hands the latest value from one writer thread to one reader thread without
+// locks or waiting. The writer fills back () and publish ()es it, the reader
+// update ()s and reads front (). Neither side ever sees the other's slot, and
+// values published faster than they are read are skipped, never queued.
+template <class _Entry>
+class triple_buffer
+{
+public:
+    triple_buffer () = default;
+
+    triple_buffer (const triple_buffer &other) = delete;
+    triple_buffer & operator= (const triple_buffer &other) = delete;
+
+    // Writer only. Still holds what was written two publishes ago, so fill in
+    // every field.
+    inline _Entry & back ()
+    {
+        return _slots[_back];
+    }
+
+    // Writer only. Makes back () the latest value and hands out a free slot.
+    inline void publish ()
+    {
+        _back = _middle.exchange (_back | fresh, std::memory_order_acq_rel) & index_mask;
+    }
+
+    // Reader only. Takes the latest value if one was published since the last
+    // update (), returns false otherwise.
+    inline const bool update ()
+    {
+        if (! (_middle.load (std::memory_order_relaxed) & fresh))
+            return false;
+
+        _front = _middle.exchange (_front, std::memory_order_acq_rel) & index_mask;
+        return true;
+    }
+
+    // Reader only.
+    inline const _Entry & front () const
+    {
+        return _slots[_front];
+    }
+
+private:
+    static constexpr std::uint8_t index_mask = 3U;
+    static constexpr std::uint8_t fresh = 4U;
+
+    std::array <_Entry, 3> _slots {};
+    alignas (64) std::uint8_t _back = 0U;
+    alignas (64) std::atomic <std::uint8_t> _middle {1U};
+    alignas (64) std::uint8_t _front = 2U;
+};
+
+} // namespace fost
+
+#endif // _BLOCKYTRY_CORE_TRIPLE_BUFFER_H_
@@ -1,10 +1,12 @@
-#ifndef _BLOCKYTRY_IO_LOOKUP_TABLE_H_
-#define _BLOCKYTRY_IO_LOOKUP_TABLE_H_
+#ifndef _BLOCKYTRY_SHARED_LOOKUP_TABLE_H_
+#define _BLOCKYTRY_SHARED_LOOKUP_TABLE_H_
 
 #include <algorithm>
 #include <array>
 #include <cstddef>
 #include <stdexcept>
+#include <string_view>
+#include <utility>
 
 namespace shared
 {
@@ -26,6 +28,16 @@ struct _lookup_table_impl
         
         return itr->second;
     }
+
+    [[nodiscard]] consteval std::size_t index_of (const _Key &key) const
+    {
+        const auto itr = std::find_if (std::begin (data), std::end (data),
+            [&key] (const auto &v) { return (v.first == key); });
+        if (itr == std::end (data))
+            throw std::range_error ("Key not found in lookup_table.");
+
+        return static_cast <std::size_t> (itr - std::begin (data));
+    }
 };
 
 template <typename _Key, typename _Value, std::size_t size>
@@ -40,6 +52,19 @@ consteval _Value lookup (const lut <std::string_view, _Value, size> &lut, const
     return _lookup_table_impl <std::string_view, _Value, size> {{lut}}.at (key);
 }
 
+// Position of key in the table, for dense indices known at compile time.
+template <typename _Key, typename _Value, std::size_t size>
+consteval std::size_t index_of (const lut <_Key, _Value, size> &lut, const _Key &key)
+{
+    return _lookup_table_impl <_Key, _Value, size> {{lut}}.index_of (key);
+}
+
+template <typename _Value, std::size_t size>
+consteval std::size_t index_of (const lut <std::string_view, _Value, size> &lut, const char *key)
+{
+    return _lookup_table_impl <std::string_view, _Value, size> {{lut}}.index_of (key);
+}
+
 } // namespace shared
 
-#endif // _BLOCKYTRY_IO_LOOKUP_TABLE_H_
\ No newline at end of file
+#endif // _BLOCKYTRY_SHARED_LOOKUP_TABLE_H_
\ No newline at end of file
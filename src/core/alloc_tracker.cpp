@@ -0,0 +1,157 @@
+#include <core/alloc_tracker.hpp>
+
+#ifdef FOST_TRACK_ALLOCATIONS
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace fost
+{
+namespace alloc
+{
+
+namespace // anonymous
+{
+
+// Same contract as the default operator new: retry through the new handler,
+// throw once there is none.
+static void * allocate (std::size_t size)
+{
+    if (! size)
+        size = 1U;
+
+    for (;;)
+    {
+        if (void *ptr = std::malloc (size))
+        {
+            ++tl_counts.allocations;
+            tl_counts.bytes += size;
+            return ptr;
+        }
+
+        const std::new_handler handler = std::get_new_handler ();
+        if (! handler)
+            throw std::bad_alloc {};
+        handler ();
+    }
+}
+
+static void * allocate_aligned (std::size_t size, const std::align_val_t alignment)
+{
+    const std::size_t align = static_cast <std::size_t> (alignment);
+    // aligned_alloc wants a size that is a multiple of the alignment.
+    size = (size + align - 1U) & ~(align - 1U);
+    if (! size)
+        size = align;
+
+    for (;;)
+    {
+#ifdef _WIN32
+        void *ptr = ::_aligned_malloc (size, align);
+#else
+        void *ptr = std::aligned_alloc (align, size);
+#endif
+        if (ptr)
+        {
+            ++tl_counts.allocations;
+            tl_counts.bytes += size;
+            return ptr;
+        }
+
+        const std::new_handler handler = std::get_new_handler ();
+        if (! handler)
+            throw std::bad_alloc {};
+        handler ();
+    }
+}
+
+static void deallocate (void *ptr) noexcept
+{
+    if (! ptr)
+        return;
+
+    ++tl_counts.frees;
+    std::free (ptr);
+}
+
+static void deallocate_aligned (void *ptr) noexcept
+{
+    if (! ptr)
+        return;
+
+    ++tl_counts.frees;
+#ifdef _WIN32
+    ::_aligned_free (ptr);
+#else
+    std::free (ptr);
+#endif
+}
+
+} // namespace anonymous
+
+} // namespace alloc
+} // namespace fost
+
+// -=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+// Replaceable global allocation functions.
+
+void * operator new (std::size_t size)
+{
+    return fost::alloc::allocate (size);
+}
+
+void * operator new[] (std::size_t size)
+{
+    return fost::alloc::allocate (size);
+}
+
+void * operator new (std::size_t size, const std::nothrow_t&) noexcept
+{
+    try { return fost::alloc::allocate (size); }
+    catch (...) { return nullptr; }
+}
+
+void * operator new[] (std::size_t size, const std::nothrow_t&) noexcept
+{
+    try { return fost::alloc::allocate (size); }
+    catch (...) { return nullptr; }
+}
+
+void * operator new (std::size_t size, std::align_val_t alignment)
+{
+    return fost::alloc::allocate_aligned (size, alignment);
+}
+
+void * operator new[] (std::size_t size, std::align_val_t alignment)
+{
+    return fost::alloc::allocate_aligned (size, alignment);
+}
+
+void * operator new (std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    try { return fost::alloc::allocate_aligned (size, alignment); }
+    catch (...) { return nullptr; }
+}
+
+void * operator new[] (std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    try { return fost::alloc::allocate_aligned (size, alignment); }
+    catch (...) { return nullptr; }
+}
+
+void operator delete (void *ptr) noexcept { fost::alloc::deallocate (ptr); }
+void operator delete[] (void *ptr) noexcept { fost::alloc::deallocate (ptr); }
+void operator delete (void *ptr, std::size_t) noexcept { fost::alloc::deallocate (ptr); }
+void operator delete[] (void *ptr, std::size_t) noexcept { fost::alloc::deallocate (ptr); }
+void operator delete (void *ptr, const std::nothrow_t&) noexcept { fost::alloc::deallocate (ptr); }
+void operator delete[] (void *ptr, const std::nothrow_t&) noexcept { fost::alloc::deallocate (ptr); }
+
+void operator delete (void *ptr, std::align_val_t) noexcept { fost::alloc::deallocate_aligned (ptr); }
+void operator delete[] (void *ptr, std::align_val_t) noexcept { fost::alloc::deallocate_aligned (ptr); }
+void operator delete (void *ptr, std::size_t, std::align_val_t) noexcept { fost::alloc::deallocate_aligned (ptr); }
+void operator delete[] (void *ptr, std::size_t, std::align_val_t) noexcept { fost::alloc::deallocate_aligned (ptr); }
+void operator delete (void *ptr, std::align_val_t, const std::nothrow_t&) noexcept { fost::alloc::deallocate_aligned (ptr); }
+void operator delete[] (void *ptr, std::align_val_t, const std::nothrow_t&) noexcept { fost::alloc::deallocate_aligned (ptr); }
+
+#endif // FOST_TRACK_ALLOCATIONS
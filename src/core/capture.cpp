@@ -0,0 +1,213 @@
+#include <core/capture.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <core/capture_format.hpp>
+#include <core/cpu_profiler.hpp>
+#include <core/runtime.hpp>
+
+namespace fost
+{
+namespace capture
+{
+
+// Records buffered per chunk before hitting the file.
+static constexpr std::size_t s_chunk_records = 4096U;
+
+static std::ofstream s_file;
+static clock::rep s_start = 0;
+
+static std::vector <frame_entry> s_frames;
+static std::vector <tick_entry> s_ticks;
+static std::vector <zone_entry> s_zones;
+
+// Pending names and threads chunks, already serialized.
+static std::vector <char> s_names;
+static std::uint32_t s_names_count = 0U;
+static std::vector <char> s_threads;
+static std::uint32_t s_threads_count = 0U;
+
+static zone_collector s_collector;
+
+static void write_chunk (const chunk_type type, const std::uint32_t count,
+                         const void *data, const std::size_t bytes)
+{
+    if (! count)
+        return;
+
+    const chunk_header header {type, count, bytes};
+    s_file.write (reinterpret_cast <const char*> (&header), sizeof (header));
+    s_file.write (static_cast <const char*> (data), static_cast <std::streamsize> (bytes));
+}
+
+template <class _Entry>
+static void flush (const chunk_type type, std::vector <_Entry> &entries)
+{
+    write_chunk (type, static_cast <std::uint32_t> (entries.size ()),
+                 entries.data (), entries.size () * sizeof (_Entry));
+    entries.clear ();
+}
+
+void append_name (std::vector <char> &chunk, const std::uint32_t id, const std::string_view str)
+{
+    const name_entry entry {id, static_cast <std::uint32_t> (str.size ())};
+    const std::size_t offset = chunk.size ();
+    chunk.resize (offset + sizeof (entry) + padded_size (str.size ()), '\0');
+    std::memcpy (chunk.data () + offset, &entry, sizeof (entry));
+    std::memcpy (chunk.data () + offset + sizeof (entry), str.data (), str.size ());
+}
+
+static void flush_zones ()
+{
+    // Names and threads must precede the zones referring to them.
+    write_chunk (chunk_type::threads, s_threads_count, s_threads.data (), s_threads.size ());
+    s_threads.clear ();
+    s_threads_count = 0U;
+    write_chunk (chunk_type::names, s_names_count, s_names.data (), s_names.size ());
+    s_names.clear ();
+    s_names_count = 0U;
+    flush (chunk_type::zones, s_zones);
+}
+
+static std::int64_t to_ns (const clock::duration duration)
+{
+    return std::chrono::duration_cast <std::chrono::nanoseconds> (duration).count ();
+}
+
+const file_header make_header (const clock::rep origin)
+{
+    file_header header {};
+    std::memcpy (header.magic, magic, sizeof (magic));
+    header.version = version;
+    header.tps = fost::runtime::tps ();
+    header.start_ns = to_ns (clock::duration {origin});
+    header.wall_start_s = std::chrono::duration_cast <std::chrono::seconds> (
+        fost::runtime::beginning ().time_since_epoch ()).count ();
+    return header;
+}
+
+const frame_entry make_frame (const clock::rep origin, const clock::time_point begin, const clock::duration duration,
+                              const std::uint32_t ticks, const alloc::counts &allocations)
+{
+    return {relative_ns (origin, begin.time_since_epoch ().count ()), to_ns (duration), ticks,
+            static_cast <std::uint32_t> (allocations.allocations), allocations.bytes};
+}
+
+void zone_collector::reset (const clock::rep origin)
+{
+    _origin = origin;
+    _name_ids.clear ();
+    _cursors.clear ();
+    cpu_profiler::for_each ([this] (const cpu_profiler &profiler)
+    {
+        find_cursor (profiler.thread_id (), profiler.published ());
+    });
+}
+
+zone_collector::cursor & zone_collector::find_cursor (const std::uint32_t tid, const std::uint64_t position)
+{
+    auto c = std::find_if (_cursors.begin (), _cursors.end (),
+        [tid] (const cursor &c) { return (c.tid == tid); });
+    if (c != _cursors.end ())
+        return *c;
+
+    return _cursors.emplace_back (cursor {tid, position, false});
+}
+
+const bool start (const std::string &path)
+{
+    stop ();
+
+    s_file.open (path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (! s_file.good ())
+    {
+        s_file.close ();
+        return false;
+    }
+
+    s_start = profiler_now ();
+
+    const file_header header = make_header (s_start);
+    s_file.write (reinterpret_cast <const char*> (&header), sizeof (header));
+
+    s_frames.reserve (s_chunk_records);
+    s_ticks.reserve (s_chunk_records);
+    s_zones.reserve (s_chunk_records);
+
+    // Only zones published from now on belong to this capture.
+    s_collector.reset (s_start);
+
+    return true;
+}
+
+void stop ()
+{
+    if (! s_file.is_open ())
+        return;
+
+    collect_zones ();
+    flush (chunk_type::frames, s_frames);
+    flush (chunk_type::ticks, s_ticks);
+    flush_zones ();
+    s_file.close ();
+}
+
+const bool is_recording ()
+{
+    return s_file.is_open ();
+}
+
+void record_frame (const clock::time_point begin, const clock::duration duration, const std::uint32_t ticks,
+                   const alloc::counts &allocations)
+{
+    if (! is_recording ())
+        return;
+
+    s_frames.push_back (make_frame (s_start, begin, duration, ticks, allocations));
+    if (s_frames.size () == s_chunk_records)
+        flush (chunk_type::frames, s_frames);
+}
+
+void record_tick (const clock::time_point begin, const clock::duration duration)
+{
+    if (! is_recording ())
+        return;
+
+    s_ticks.push_back ({relative_ns (s_start, begin.time_since_epoch ().count ()), to_ns (duration)});
+    if (s_ticks.size () == s_chunk_records)
+        flush (chunk_type::ticks, s_ticks);
+}
+
+void collect_zones ()
+{
+    if (! is_recording ())
+        return;
+
+    s_collector.collect (
+        [] (const std::uint32_t id, const std::string &name)
+        {
+            append_name (s_threads, id, name);
+            ++s_threads_count;
+        },
+        [] (const std::uint32_t id, const char *name)
+        {
+            append_name (s_names, id, name);
+            ++s_names_count;
+        },
+        [] (const zone_entry &zone)
+        {
+            s_zones.push_back (zone);
+            if (s_zones.size () == s_chunk_records)
+                flush_zones ();
+        });
+}
+
+} // namespace capture
+} // namespace fost
@@ -0,0 +1,162 @@
+#include <core/coroutine.hpp>
+
+#include <array>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#include <core/jobs.hpp>
+#include <core/timer_wheel.hpp>
+
+namespace fost
+{
+
+namespace // anonymous
+{
+
+// Frame sizes served from the pools, each a power of two.
+constexpr std::size_t smallest_frame = 128U;
+constexpr std::size_t size_classes = 6U;  // 128 to 4096 bytes.
+
+// Blocks carved out at once when a class runs dry.
+constexpr std::size_t blocks_per_slab = 32U;
+
+struct free_block
+{
+    free_block *next;
+};
+
+struct frame_pool
+{
+    std::mutex mutex;
+    free_block *free = nullptr;
+};
+
+} // namespace anonymous
+
+static std::array <frame_pool, size_classes> s_pools;
+
+static std::mutex s_mutex;
+static timer_wheel <std::coroutine_handle <>> s_waiting;
+
+// Only touched by resume_coroutines.
+static std::vector <std::coroutine_handle <>> s_due;
+
+// Jobs resuming coroutines on workers, waited on at shutdown.
+static jobs::counter s_worker_jobs;
+
+static std::size_t size_class (const std::size_t size)
+{
+    std::size_t c = 0U;
+    while (c < size_classes && (smallest_frame << c) < size)
+        ++c;
+    return c;
+}
+
+namespace detail
+{
+
+void * allocate_frame (const std::size_t size)
+{
+    const std::size_t c = size_class (size);
+    if (c == size_classes)
+        return ::operator new (size);
+
+    frame_pool &pool = s_pools[c];
+    std::lock_guard <std::mutex> lock {pool.mutex};
+    if (! pool.free)
+    {
+        // Slabs are never returned, frames of this size will be needed again.
+        const std::size_t block = smallest_frame << c;
+        char *slab = static_cast <char*> (::operator new (block * blocks_per_slab));
+        for (std::size_t i = 0U; i < blocks_per_slab; ++i)
+            pool.free = ::new (slab + i * block) free_block {pool.free};
+    }
+
+    free_block *frame = pool.free;
+    pool.free = frame->next;
+    return frame;
+}
+
+void free_frame (void *frame, const std::size_t size) noexcept
+{
+    const std::size_t c = size_class (size);
+    if (c == size_classes)
+    {
+        ::operator delete (frame);
+        return;
+    }
+
+    frame_pool &pool = s_pools[c];
+    std::lock_guard <std::mutex> lock {pool.mutex};
+    pool.free = ::new (frame) free_block {pool.free};
+}
+
+void schedule (std::coroutine_handle <> h, const std::int64_t delay)
+{
+    std::lock_guard <std::mutex> lock {s_mutex};
+    s_waiting.schedule (runtime::ticks {delay}, h);
+}
+
+void schedule_on_worker (std::coroutine_handle <> h)
+{
+    jobs::run (s_worker_jobs, [h] () { h.resume (); });
+}
+
+const bool has_workers ()
+{
+    return (jobs::worker_count () > 1U && jobs::this_worker () >= 0);
+}
+
+} // namespace detail
+
+namespace runtime
+{
+
+void resume_coroutines ()
+{
+    // Resume outside the lock, coroutines schedule themselves again.
+    s_due.clear ();
+    {
+        std::lock_guard <std::mutex> lock {s_mutex};
+        s_waiting.advance ([] (const std::coroutine_handle <> h) { s_due.push_back (h); });
+    }
+
+    for (std::coroutine_handle <> h : s_due)
+        h.resume ();
+}
+
+const std::int64_t coroutine_tick ()
+{
+    std::lock_guard <std::mutex> lock {s_mutex};
+    return s_waiting.now ().count ();
+}
+
+const std::size_t suspended_coroutines ()
+{
+    std::lock_guard <std::mutex> lock {s_mutex};
+    return s_waiting.pending ();
+}
+
+void wait_worker_coroutines ()
+{
+    jobs::wait (s_worker_jobs);
+}
+
+void destroy_coroutines ()
+{
+    std::vector <std::coroutine_handle <>> pending;
+    {
+        std::lock_guard <std::mutex> lock {s_mutex};
+        s_waiting.clear ([&pending] (const std::coroutine_handle <> h) { pending.push_back (h); });
+    }
+
+    for (const std::coroutine_handle <> h : pending)
+        h.destroy ();
+}
+
+} // namespace runtime
+} // namespace fost
@@ -1,9 +1,14 @@
 #include <core/cpu_profiler.hpp>
 
+#include <algorithm>
+#include <atomic>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <sstream>
 #include <thread>
+#include <vector>
 
 namespace fost
 {
@@ -20,6 +25,83 @@ static const std::string tid_to_string (const std::thread::id &tid)
 
 static thread_local std::string tl_thread_name = tid_to_string (std::this_thread::get_id ());
 
+// Source of cpu_profiler::thread_id ().
+static std::atomic <std::uint32_t> s_next_thread_id {0U};
+
+cpu_profiler::cpu_profiler ()
+    : cpu_profiler {get_thread_name ()}
+{
+}
+
+cpu_profiler::cpu_profiler (const std::string &track_name)
+    : _records {new zone_record[capacity]}
+    , _head {0U}
+    , _depth {0U}
+    , _thread_id {s_next_thread_id.fetch_add (1U, std::memory_order_relaxed)}
+    , _thread_name {track_name}
+{
+    std::lock_guard <std::mutex> lock {registry_mutex ()};
+    registry ().push_back (this);
+    std::cout << "Initialized CPU profiler.\n";
+}
+
+cpu_profiler::~cpu_profiler ()
+{
+    std::lock_guard <std::mutex> lock {registry_mutex ()};
+    auto &profilers = registry ();
+    profilers.erase (std::remove (profilers.begin (), profilers.end (), this), profilers.end ());
+    std::cout << "Clean up CPU profiler.\n";
+}
+
+std::unique_ptr <cpu_profiler> cpu_profiler::make_track (const std::string &name)
+{
+    return std::unique_ptr <cpu_profiler> {new cpu_profiler {name}};
+}
+
+std::mutex & cpu_profiler::registry_mutex ()
+{
+    static std::mutex mutex;
+    return mutex;
+}
+
+std::vector <cpu_profiler*> & cpu_profiler::registry ()
+{
+    static std::vector <cpu_profiler*> profilers;
+    return profilers;
+}
+
+std::size_t cpu_profiler::collect (std::uint64_t &cursor, std::vector <zone_record> &out) const
+{
+    // The owner may be writing record head right now, over head - capacity.
+    const std::uint64_t head = _head.load (std::memory_order_acquire);
+    std::uint64_t first = cursor;
+    if (head - first >= capacity)
+        first = head - capacity + 1;
+
+    const std::size_t start = out.size ();
+    for (std::uint64_t i = first; i < head; ++i)
+        out.push_back (_records[i & (capacity - 1)]);
+
+    // The owner may have lapped us while copying, drop what it overwrote,
+    // including the record under the one it is writing now.
+    std::atomic_thread_fence (std::memory_order_acquire);
+    const std::uint64_t lapped = _head.load (std::memory_order_relaxed);
+    if (lapped - first >= capacity)
+    {
+        const std::uint64_t torn = std::min <std::uint64_t> (lapped - capacity - first + 1, head - first);
+        out.erase (out.begin () + start, out.begin () + start + torn);
+    }
+
+    cursor = head;
+    return (out.size () - start);
+}
+
+const std::string cpu_profiler::thread_name () const
+{
+    std::lock_guard <std::mutex> lock {_thread_name_mutex};
+    return _thread_name;
+}
+
 const std::string & get_thread_name ()
 {
     return tl_thread_name;
@@ -28,6 +110,10 @@ const std::string & get_thread_name ()
 void set_thread_name (const std::string &tname)
 {
     tl_thread_name = tname;
+
+    cpu_profiler &profiler = cpu_profiler::get ();
+    std::lock_guard <std::mutex> lock {profiler._thread_name_mutex};
+    profiler._thread_name = tname;
 }
 
 } // namespace fost
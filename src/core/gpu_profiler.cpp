@@ -0,0 +1,200 @@
+#include <core/gpu_profiler.hpp>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+
+#include <glad/gl.h>
+
+#include <core/cpu_profiler.hpp>
+
+namespace fost
+{
+namespace gpu
+{
+
+namespace // anonymous
+{
+
+struct zone_slot
+{
+    const char *name;
+    std::uint16_t depth;
+};
+
+// Queries of one frame. Zone i owns queries 2i (begin) and 2i + 1 (end),
+// zone 0 is the frame itself.
+struct frame_slot
+{
+    std::array <GLuint, max_zones * 2> queries {};
+    std::array <zone_slot, max_zones> zones {};
+    std::uint32_t count = 0U;
+    bool pending = false;
+};
+
+// Frames between two clock calibrations, to follow drift between the GPU and
+// CPU clocks.
+constexpr std::uint32_t calibration_interval = 256U;
+
+} // namespace anonymous
+
+static std::array <frame_slot, frames_in_flight> s_frames;
+static std::uint32_t s_current = 0U;
+static bool s_available = false;
+static bool s_in_frame = false;
+static std::uint16_t s_depth = 0U;
+
+static std::unique_ptr <cpu_profiler> s_track;
+// profiler_now () minus GPU time, both in clock ticks.
+static clock::rep s_offset = 0;
+static std::uint32_t s_frames_since_calibration = 0U;
+static clock::duration s_last_frame_time {0};
+static std::uint64_t s_dropped = 0U;
+
+static clock::rep to_clock (const std::int64_t gpu_ns)
+{
+    return std::chrono::duration_cast <clock::duration> (std::chrono::nanoseconds {gpu_ns}).count ();
+}
+
+static void calibrate ()
+{
+    GLint64 gpu_now = 0;
+    glGetInteger64v (GL_TIMESTAMP, &gpu_now);
+    s_offset = profiler_now () - to_clock (gpu_now);
+    s_frames_since_calibration = 0U;
+}
+
+// Publishes a finished frame to the GPU track, root last like CPU zones.
+static void resolve (frame_slot &slot)
+{
+    GLint available = 0;
+    glGetQueryObjectiv (slot.queries[1], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (! available)
+    {
+        ++s_dropped;
+        return;
+    }
+
+    std::array <GLuint64, max_zones * 2> results;
+    for (std::uint32_t q = 0; q < slot.count * 2; ++q)
+        glGetQueryObjectui64v (slot.queries[q], GL_QUERY_RESULT, &results[q]);
+
+    for (std::uint32_t i = 1; i <= slot.count; ++i)
+    {
+        const std::uint32_t z = i % slot.count;
+        zone_record record {};
+        record.name = slot.zones[z].name;
+        record.begin = to_clock (static_cast <std::int64_t> (results[z * 2])) + s_offset;
+        record.end = to_clock (static_cast <std::int64_t> (results[z * 2 + 1])) + s_offset;
+        record.depth = slot.zones[z].depth;
+        s_track->publish (record);
+    }
+
+    s_last_frame_time = clock::duration {to_clock (static_cast <std::int64_t> (results[1] - results[0]))};
+}
+
+const bool init ()
+{
+    GLint bits = 0;
+    glGetQueryiv (GL_TIMESTAMP, GL_QUERY_COUNTER_BITS, &bits);
+    if (! bits)
+    {
+        std::cerr << "warn: GPU timestamp queries unavailable, GPU zones are disabled\n";
+        return false;
+    }
+
+    for (frame_slot &slot : s_frames)
+    {
+        glGenQueries (static_cast <GLsizei> (slot.queries.size ()), slot.queries.data ());
+        slot.count = 0U;
+        slot.pending = false;
+    }
+
+    s_track = cpu_profiler::make_track ("GPU");
+    calibrate ();
+    s_current = 0U;
+    s_available = true;
+    return true;
+}
+
+void shutdown ()
+{
+    if (! s_available)
+        return;
+
+    for (frame_slot &slot : s_frames)
+        glDeleteQueries (static_cast <GLsizei> (slot.queries.size ()), slot.queries.data ());
+    s_track.reset ();
+    s_available = false;
+}
+
+const bool is_available ()
+{
+    return s_available;
+}
+
+void begin_frame ()
+{
+    if (! s_available)
+        return;
+
+    frame_slot &slot = s_frames[s_current];
+    if (slot.pending)
+        resolve (slot);
+    slot.count = 0U;
+    slot.pending = false;
+
+    if (++s_frames_since_calibration >= calibration_interval)
+        calibrate ();
+
+    s_in_frame = true;
+    s_depth = 0U;
+    begin_zone ("gpu frame");
+}
+
+void end_frame ()
+{
+    if (! s_in_frame)
+        return;
+
+    end_zone (0U);
+    s_frames[s_current].pending = true;
+    s_current = (s_current + 1U) % frames_in_flight;
+    s_in_frame = false;
+}
+
+const clock::duration last_frame_time ()
+{
+    return s_last_frame_time;
+}
+
+const std::uint64_t dropped ()
+{
+    return s_dropped;
+}
+
+std::uint32_t begin_zone (const char *name)
+{
+    frame_slot &slot = s_frames[s_current];
+    if (! s_in_frame || slot.count == max_zones)
+        return max_zones;
+
+    const std::uint32_t index = slot.count++;
+    slot.zones[index] = {name, s_depth++};
+    glQueryCounter (slot.queries[index * 2], GL_TIMESTAMP);
+    return index;
+}
+
+void end_zone (const std::uint32_t index)
+{
+    if (! s_in_frame || index >= max_zones)
+        return;
+
+    glQueryCounter (s_frames[s_current].queries[index * 2 + 1], GL_TIMESTAMP);
+    --s_depth;
+}
+
+} // namespace gpu
+} // namespace fost
@@ -0,0 +1,97 @@
+#include <core/input.hpp>
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+namespace fost
+{
+namespace input
+{
+
+using detail::s_keys;
+using detail::s_snapshot;
+using detail::is_valid;
+
+// Scancodes released since the last prune (), so pruning only touches those
+// keys.
+static key_mask s_prune {};
+// Keys down now, and keys pressed or released since the last sample ().
+static key_mask s_down {};
+static key_mask s_pressed {};
+static key_mask s_released {};
+// s_down as of the previous sample ().
+static key_mask s_was_down {};
+
+void press (const int scancode, const fost::clock::time_point time)
+{
+    if (! is_valid (scancode))
+        return;
+
+    s_keys[scancode].push (time);
+    s_down.set (scancode);
+    s_pressed.set (scancode);
+}
+
+void release (const int scancode, const fost::clock::time_point time)
+{
+    if (! is_valid (scancode))
+        return;
+
+    s_keys[scancode].complete (time);
+    s_prune.set (scancode);
+    s_released.set (scancode);
+    s_down.reset (scancode);
+}
+
+void prune ()
+{
+    for (std::size_t word = 0U; word < s_prune.words.size (); ++word)
+    {
+        for (std::uint64_t bits = s_prune.words[word]; bits != 0U; bits &= bits - 1U)
+            s_keys[word * 64U + std::countr_zero (bits)].prune ();
+    }
+    s_prune = {};
+}
+
+void sample ()
+{
+    // A key down in both snapshots may still have been released and pressed
+    // again in between, only the accumulated edges tell. Releases come from
+    // the accumulator alone: a key tapped last tick is down in the previous
+    // snapshot and up now, but its release was reported last tick already.
+    const key_mask previous = s_snapshot.current;
+    const key_mask current = s_down | s_pressed;
+    sample ({current, s_pressed | (current & ~previous), s_released});
+    s_pressed = {};
+    s_released = {};
+
+    detail::s_carried = s_was_down;
+    s_was_down = s_down;
+}
+
+void sample (const key_record &record)
+{
+    const key_mask previous = s_snapshot.current;
+    s_snapshot.current = record.current;
+    s_snapshot.pressed = record.pressed;
+    s_snapshot.released = record.released;
+    s_snapshot.held = record.current & previous;
+
+    // Counted in ticks rather than time, so replays count the same. Only keys
+    // down now or last tick can have a count to update.
+    const key_mask counting = s_snapshot.held & ~s_snapshot.pressed;
+    const key_mask touched = record.current | previous;
+    for (std::size_t word = 0U; word < touched.words.size (); ++word)
+    {
+        for (std::uint64_t bits = touched.words[word]; bits != 0U; bits &= bits - 1U)
+        {
+            const int scancode = static_cast <int> (word * 64U + std::countr_zero (bits));
+            detail::s_held[scancode] = counting.test (scancode) ? detail::s_held[scancode] + 1L : 0L;
+        }
+    }
+}
+
+} // namespace input
+} // namespace fost
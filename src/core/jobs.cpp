@@ -0,0 +1,276 @@
+#include <core/jobs.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include <core/cpu_profiler.hpp>
+#include <core/sampler.hpp>
+
+namespace fost
+{
+namespace jobs
+{
+
+namespace // anonymous
+{
+
+// Chase-Lev deque with a fixed capacity, after Le et al., "Correct and
+// Efficient Work-Stealing for Weak Memory Models" (2013). The owner pushes
+// and pops at the bottom, thieves take from the top.
+class work_deque
+{
+public:
+    // Owner only. Returns false when full.
+    bool push (job *j)
+    {
+        const std::int64_t b = _bottom.load (std::memory_order_relaxed);
+        const std::int64_t t = _top.load (std::memory_order_acquire);
+        if (b - t >= static_cast <std::int64_t> (deque_capacity))
+            return false;
+
+        _jobs[b & (deque_capacity - 1)].store (j, std::memory_order_relaxed);
+        _bottom.store (b + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Owner only.
+    job * pop ()
+    {
+        const std::int64_t b = _bottom.load (std::memory_order_relaxed) - 1;
+        _bottom.store (b, std::memory_order_relaxed);
+        std::atomic_thread_fence (std::memory_order_seq_cst);
+        std::int64_t t = _top.load (std::memory_order_relaxed);
+
+        if (t > b)
+        {
+            _bottom.store (b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        job *j = _jobs[b & (deque_capacity - 1)].load (std::memory_order_relaxed);
+        if (t == b)
+        {
+            // Last job, race the thieves for it.
+            if (! _top.compare_exchange_strong (t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                j = nullptr;
+            _bottom.store (b + 1, std::memory_order_relaxed);
+        }
+        return j;
+    }
+
+    // Any thread.
+    job * steal ()
+    {
+        std::int64_t t = _top.load (std::memory_order_acquire);
+        std::atomic_thread_fence (std::memory_order_seq_cst);
+        const std::int64_t b = _bottom.load (std::memory_order_acquire);
+        if (t >= b)
+            return nullptr;
+
+        job *j = _jobs[t & (deque_capacity - 1)].load (std::memory_order_relaxed);
+        if (! _top.compare_exchange_strong (t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            return nullptr;
+        return j;
+    }
+
+private:
+    alignas (64) std::atomic <std::int64_t> _top {0};
+    alignas (64) std::atomic <std::int64_t> _bottom {0};
+    alignas (64) std::array <std::atomic <job*>, deque_capacity> _jobs {};
+};
+
+struct worker
+{
+    work_deque deque;
+    std::array <job, job_pool_size> pool;
+    std::size_t next_job = 0U;
+    std::uint32_t rng = 0U;
+    std::thread thread;
+};
+
+// Idle spins before a worker goes to sleep.
+constexpr int spin_count = 64;
+
+} // namespace anonymous
+
+static std::unique_ptr <worker[]> s_workers;
+static std::size_t s_worker_count = 0U;
+static std::atomic <bool> s_running {false};
+
+// Bumped on every submit; sleeping workers wait for it to change.
+static std::atomic <std::uint32_t> s_epoch {0U};
+static std::atomic <std::uint32_t> s_sleeping {0U};
+
+static thread_local int tl_worker = -1;
+
+// Own deque first, then steal starting from a random victim.
+static job * find_job (worker &self, const std::size_t index)
+{
+    if (job *j = self.deque.pop ())
+        return j;
+
+    // xorshift32
+    self.rng ^= self.rng << 13;
+    self.rng ^= self.rng >> 17;
+    self.rng ^= self.rng << 5;
+    const std::size_t first = self.rng % s_worker_count;
+    for (std::size_t i = 0U; i < s_worker_count; ++i)
+    {
+        const std::size_t victim = (first + i) % s_worker_count;
+        if (victim == index)
+            continue;
+        if (job *j = s_workers[victim].deque.steal ())
+            return j;
+    }
+    return nullptr;
+}
+
+static void execute (job &j)
+{
+    FOST_PROFILE_ZONE ("job");
+    j.execute ();
+}
+
+static void worker_main (const std::size_t index)
+{
+    tl_worker = static_cast <int> (index);
+    fost::set_thread_name ("Worker " + std::to_string (index));
+    fost::sampler::register_thread ();
+
+    worker &self = s_workers[index];
+    while (s_running.load (std::memory_order_relaxed))
+    {
+        job *j = nullptr;
+        for (int spin = 0; ! j && spin < spin_count; ++spin)
+        {
+            j = find_job (self, index);
+            if (! j)
+                std::this_thread::yield ();
+        }
+        if (j)
+        {
+            execute (*j);
+            continue;
+        }
+
+        // Read the epoch before the last look, so a submit racing with it
+        // changes the epoch and the wait returns at once.
+        const std::uint32_t epoch = s_epoch.load (std::memory_order_seq_cst);
+        if (! s_running.load (std::memory_order_seq_cst))
+            break;
+        if ((j = find_job (self, index)))
+        {
+            execute (*j);
+            continue;
+        }
+
+        s_sleeping.fetch_add (1U, std::memory_order_seq_cst);
+        s_epoch.wait (epoch, std::memory_order_seq_cst);
+        s_sleeping.fetch_sub (1U, std::memory_order_relaxed);
+    }
+}
+
+void init (std::size_t worker_count)
+{
+    if (s_worker_count)
+        return;
+
+    if (! worker_count)
+        worker_count = std::max (1U, std::thread::hardware_concurrency ());
+
+    s_workers.reset (new worker[worker_count]);
+    s_worker_count = worker_count;
+    for (std::size_t i = 0U; i < worker_count; ++i)
+        s_workers[i].rng = static_cast <std::uint32_t> (i * 2654435761U + 1U);
+
+    tl_worker = 0;
+    s_running.store (true, std::memory_order_relaxed);
+    for (std::size_t i = 1U; i < worker_count; ++i)
+        s_workers[i].thread = std::thread {worker_main, i};
+}
+
+void shutdown ()
+{
+    if (! s_worker_count)
+        return;
+
+    s_running.store (false, std::memory_order_seq_cst);
+    s_epoch.fetch_add (1U, std::memory_order_seq_cst);
+    s_epoch.notify_all ();
+    for (std::size_t i = 1U; i < s_worker_count; ++i)
+        s_workers[i].thread.join ();
+
+    s_workers.reset ();
+    s_worker_count = 0U;
+    tl_worker = -1;
+}
+
+const std::size_t worker_count ()
+{
+    return s_worker_count;
+}
+
+const int this_worker ()
+{
+    return tl_worker;
+}
+
+job & allocate ()
+{
+    assert (tl_worker >= 0);
+    const std::size_t index = static_cast <std::size_t> (tl_worker);
+    worker &self = s_workers[index];
+    job &slot = self.pool[self.next_job++ & (job_pool_size - 1)];
+
+    // Wrapped around onto a job still queued or running: help run jobs until
+    // it is done instead of overwriting it.
+    while (slot.pending.load (std::memory_order_acquire))
+    {
+        if (job *j = find_job (self, index))
+            execute (*j);
+        else
+            std::this_thread::yield ();
+    }
+    return slot;
+}
+
+void submit (job &j, counter &c)
+{
+    assert (tl_worker >= 0);
+    j.done = &c;
+    j.pending.store (true, std::memory_order_relaxed);
+    c._pending.fetch_add (1U, std::memory_order_relaxed);
+
+    if (! s_workers[tl_worker].deque.push (&j))
+    {
+        execute (j);
+        return;
+    }
+
+    s_epoch.fetch_add (1U, std::memory_order_seq_cst);
+    if (s_sleeping.load (std::memory_order_seq_cst))
+        s_epoch.notify_one ();
+}
+
+void wait (const counter &c)
+{
+    assert (tl_worker >= 0);
+    const std::size_t index = static_cast <std::size_t> (tl_worker);
+    worker &self = s_workers[index];
+    while (! c.done ())
+    {
+        if (job *j = find_job (self, index))
+            execute (*j);
+        else
+            std::this_thread::yield ();
+    }
+}
+
+} // namespace jobs
+} // namespace fost
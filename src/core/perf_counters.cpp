@@ -0,0 +1,166 @@
+#include <core/perf_counters.hpp>
+
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+#ifdef __linux__
+    #include <linux/perf_event.h>
+    #include <sys/ioctl.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
+namespace fost
+{
+namespace perf
+{
+
+static std::atomic <bool> s_enabled {false};
+// Set after the first failure to open counters, so no thread retries.
+static std::atomic <bool> s_unavailable {false};
+
+void set_enabled (const bool enabled)
+{
+    s_enabled.store (enabled, std::memory_order_relaxed);
+}
+
+const bool is_enabled ()
+{
+    return s_enabled.load (std::memory_order_relaxed);
+}
+
+#ifdef __linux__
+
+namespace // anonymous
+{
+
+// Counter group of one thread. The first opened event leads the group, so
+// a single read () returns all of them, scheduled on the PMU together.
+struct counter_group
+{
+    int leader = -1;
+    bool tried = false;
+    // Position of each counter in the group read, or -1 if it did not open.
+    std::array <int, counter_count> slot {-1, -1, -1, -1};
+    int opened = 0;
+    std::array <int, counter_count> fds {-1, -1, -1, -1};
+
+    ~counter_group ()
+    {
+        for (const int fd : fds)
+            if (fd >= 0)
+                ::close (fd);
+    }
+};
+
+constexpr std::array <std::uint64_t, counter_count> s_configs {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES,
+};
+
+static int open_event (const std::uint64_t config, const int group_fd)
+{
+    perf_event_attr attr;
+    std::memset (&attr, 0, sizeof (attr));
+    attr.size = sizeof (attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.disabled = (group_fd == -1) ? 1 : 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP;
+
+    // pid 0 and cpu -1: the calling thread, wherever it runs.
+    return static_cast <int> (::syscall (SYS_perf_event_open, &attr, 0, -1, group_fd, 0));
+}
+
+static void report_unavailable (const int error)
+{
+    if (! s_unavailable.exchange (true))
+        std::cerr << "warn: hardware performance counters unavailable (" << std::strerror (error)
+                  << "), profiler zones will record wall time only\n";
+}
+
+} // namespace anonymous
+
+static thread_local counter_group tl_group;
+
+static const bool open_group ()
+{
+    counter_group &g = tl_group;
+    if (g.tried)
+        return (g.leader >= 0);
+    g.tried = true;
+
+    if (s_unavailable.load (std::memory_order_relaxed))
+        return false;
+
+    for (std::size_t c = 0; c < counter_count; ++c)
+    {
+        const int fd = open_event (s_configs[c], g.leader);
+        if (fd < 0)
+        {
+            // Without a leader there is nothing to group with.
+            if (g.leader < 0)
+            {
+                report_unavailable (errno);
+                return false;
+            }
+            continue;
+        }
+
+        if (g.leader < 0)
+            g.leader = fd;
+        g.fds[c] = fd;
+        g.slot[c] = g.opened++;
+    }
+
+    ::ioctl (g.leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ::ioctl (g.leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    return true;
+}
+
+const bool available ()
+{
+    return is_enabled () && open_group ();
+}
+
+const sample read ()
+{
+    sample result {};
+    if (! available ())
+        return result;
+
+    // PERF_FORMAT_GROUP layout: u64 nr, then one u64 value per event.
+    std::array <std::uint64_t, 1 + counter_count> buffer {};
+    if (::read (tl_group.leader, buffer.data (), sizeof (buffer)) < static_cast <ssize_t> (sizeof (std::uint64_t)))
+        return result;
+
+    for (std::size_t c = 0; c < counter_count; ++c)
+        if (tl_group.slot[c] >= 0)
+            result[c] = buffer[1 + tl_group.slot[c]];
+    return result;
+}
+
+#else
+
+const bool available ()
+{
+    return false;
+}
+
+const sample read ()
+{
+    return {};
+}
+
+#endif // __linux__
+
+} // namespace perf
+} // namespace fost
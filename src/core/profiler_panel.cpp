@@ -0,0 +1,339 @@
+#include <core/profiler_panel.hpp>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <vector>
+
+#include <imgui/imgui.h>
+#include <imgui/implot.h>
+
+#include <core/cpu_profiler.hpp>
+#include <core/gpu_profiler.hpp>
+#include <core/perf_counters.hpp>
+#include <core/quality.hpp>
+#include <core/runtime.hpp>
+#include <core/tick_governor.hpp>
+
+namespace fost
+{
+namespace profiler_panel
+{
+
+namespace // anonymous
+{
+
+// Fixed size ring of samples, laid out for ImPlot's offset parameter.
+struct history
+{
+    std::array <float, history_size> values {};
+    int count = 0;
+    int head = 0;
+
+    void push (const float value)
+    {
+        values[head] = value;
+        head = (head + 1) % history_size;
+        count = std::min (count + 1, history_size);
+    }
+
+    // Index of the oldest sample.
+    int offset () const
+    {
+        return (count < history_size) ? 0 : head;
+    }
+
+    float last () const
+    {
+        return count ? values[(head + history_size - 1) % history_size] : 0.0f;
+    }
+};
+
+constexpr float flame_row_height = 18.0f;
+
+} // namespace anonymous
+
+static history s_frames;
+static history s_ticks;
+static history s_allocations;
+static alloc::counts s_last_allocations {0U, 0U, 0U};
+
+// Zones of the calling thread not yet attributed to a complete frame.
+static std::array <zone_record, flame_capacity> s_pending;
+static int s_pending_count = 0;
+
+// Zones of the last complete frame, root last.
+static std::array <zone_record, flame_capacity> s_flame;
+static int s_flame_count = 0;
+
+static std::vector <zone_record> s_collected;
+static std::uint64_t s_cursor = 0U;
+
+static float to_ms (const clock::duration d)
+{
+    return std::chrono::duration <float, std::milli> (d).count ();
+}
+
+// Zones are published when they close, so children come before their parent
+// and a depth 0 record closes a frame.
+static void gather_zones ()
+{
+    if (s_collected.capacity () < cpu_profiler::capacity)
+        s_collected.reserve (cpu_profiler::capacity);
+
+    s_collected.clear ();
+    cpu_profiler::get ().collect (s_cursor, s_collected);
+
+    for (const zone_record &zone : s_collected)
+    {
+        if (s_pending_count < flame_capacity)
+            s_pending[s_pending_count++] = zone;
+
+        if (zone.depth == 0)
+        {
+            // The root must stay last, even if the frame had too many zones.
+            s_pending[s_pending_count - 1] = zone;
+            std::copy_n (s_pending.begin (), s_pending_count, s_flame.begin ());
+            s_flame_count = s_pending_count;
+            s_pending_count = 0;
+        }
+    }
+}
+
+static ImU32 zone_color (const char *name)
+{
+    const std::size_t h = std::hash <const void*> {} (name);
+    const ImVec4 color = ImColor::HSV (static_cast <float> (h % 360U) / 360.0f, 0.55f, 0.75f);
+    return ImGui::ColorConvertFloat4ToU32 (color);
+}
+
+static void draw_flame_graph ()
+{
+    if (! s_flame_count)
+    {
+#ifdef FOST_PROFILER
+        ImGui::TextUnformatted ("No complete frame zone yet.");
+#else
+        ImGui::TextUnformatted ("Profiler zones are compiled out (BLOCKYTRY_ENABLE_PROFILER).");
+#endif
+        return;
+    }
+
+    const zone_record &root = s_flame[s_flame_count - 1];
+    const float root_ms = to_ms (clock::duration {root.end - root.begin});
+
+    std::uint16_t max_depth = 0;
+    for (int i = 0; i < s_flame_count; ++i)
+        max_depth = std::max (max_depth, s_flame[i].depth);
+
+    const ImVec2 origin = ImGui::GetCursorScreenPos ();
+    const float width = ImGui::GetContentRegionAvail ().x;
+    const float height = (max_depth + 1) * flame_row_height;
+    ImGui::Dummy ({width, height});
+
+    ImDrawList *draw_list = ImGui::GetWindowDrawList ();
+    const double scale = (root.end > root.begin) ? width / static_cast <double> (root.end - root.begin) : 0.0;
+
+    char label[64];
+    for (int i = 0; i < s_flame_count; ++i)
+    {
+        const zone_record &zone = s_flame[i];
+        const ImVec2 min {origin.x + static_cast <float> ((zone.begin - root.begin) * scale),
+                          origin.y + zone.depth * flame_row_height};
+        const ImVec2 max {std::max (min.x + 1.0f, origin.x + static_cast <float> ((zone.end - root.begin) * scale)),
+                          min.y + flame_row_height - 1.0f};
+        draw_list->AddRectFilled (min, max, zone_color (zone.name));
+
+        std::snprintf (label, sizeof (label), "%s %.2f", zone.name, to_ms (clock::duration {zone.end - zone.begin}));
+        if (ImGui::CalcTextSize (label).x < max.x - min.x - 4.0f)
+            draw_list->AddText ({min.x + 2.0f, min.y + 1.0f}, IM_COL32_WHITE, label);
+    }
+
+    ImGui::Text ("Last frame: %.2f ms across %d zones", root_ms, s_flame_count);
+}
+
+// Counter zones of the last complete frame.
+static void draw_counters ()
+{
+    if (! perf::is_enabled ())
+        return;
+
+    if (! perf::available ())
+    {
+        ImGui::TextUnformatted ("Hardware counters unavailable, see perf_event_paranoid.");
+        return;
+    }
+
+    if (! ImGui::BeginTable ("##counters", 4, ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingStretchProp))
+        return;
+
+    ImGui::TableSetupColumn ("zone");
+    ImGui::TableSetupColumn ("IPC");
+    ImGui::TableSetupColumn ("LLC miss/1k");
+    ImGui::TableSetupColumn ("br miss/1k");
+    ImGui::TableHeadersRow ();
+
+    for (int i = 0; i < s_flame_count; ++i)
+    {
+        const zone_record &zone = s_flame[i];
+        if (! zone.has_counters)
+            continue;
+
+        const double kilo_instructions = zone.counters[perf::instructions] / 1000.0;
+        const auto per_kilo = [kilo_instructions] (const std::uint64_t count)
+        {
+            return (kilo_instructions > 0.0) ? count / kilo_instructions : 0.0;
+        };
+
+        ImGui::TableNextRow ();
+        ImGui::TableNextColumn ();
+        ImGui::TextUnformatted (zone.name);
+        ImGui::TableNextColumn ();
+        ImGui::Text ("%.2f", perf::ipc (zone.counters));
+        ImGui::TableNextColumn ();
+        ImGui::Text ("%.2f", per_kilo (zone.counters[perf::cache_misses]));
+        ImGui::TableNextColumn ();
+        ImGui::Text ("%.2f", per_kilo (zone.counters[perf::branch_misses]));
+    }
+
+    ImGui::EndTable ();
+}
+
+// Heap activity of the last frame and the zones of the last complete frame
+// that allocated.
+static void draw_allocations ()
+{
+    if constexpr (! alloc::is_tracking ())
+        return;
+
+    int allocating_frames = 0;
+    for (int i = 0; i < s_allocations.count; ++i)
+        allocating_frames += (s_allocations.values[i] > 0.0f);
+
+    ImGui::Text ("Allocations %llu (%llu bytes), frees %llu | %d of last %d frames allocated",
+                 static_cast <unsigned long long> (s_last_allocations.allocations),
+                 static_cast <unsigned long long> (s_last_allocations.bytes),
+                 static_cast <unsigned long long> (s_last_allocations.frees),
+                 allocating_frames, s_allocations.count);
+
+    if (! ImGui::BeginTable ("##allocations", 3, ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingStretchProp))
+        return;
+
+    ImGui::TableSetupColumn ("zone");
+    ImGui::TableSetupColumn ("allocations");
+    ImGui::TableSetupColumn ("bytes");
+    ImGui::TableHeadersRow ();
+
+    for (int i = 0; i < s_flame_count; ++i)
+    {
+        const zone_record &zone = s_flame[i];
+        if (! zone.allocations)
+            continue;
+
+        ImGui::TableNextRow ();
+        ImGui::TableNextColumn ();
+        ImGui::TextUnformatted (zone.name);
+        ImGui::TableNextColumn ();
+        ImGui::Text ("%u", zone.allocations);
+        ImGui::TableNextColumn ();
+        ImGui::Text ("%llu", static_cast <unsigned long long> (zone.allocated_bytes));
+    }
+
+    ImGui::EndTable ();
+}
+
+static void draw_history (const char *id, const char *label, const history &h)
+{
+    if (! ImPlot::BeginPlot (id, {-1.0f, 110.0f}, ImPlotFlags_NoInputs | ImPlotFlags_NoMenus | ImPlotFlags_NoTitle))
+        return;
+
+    ImPlot::SetupAxes (nullptr, "ms", ImPlotAxisFlags_NoTickLabels, ImPlotAxisFlags_AutoFit);
+    ImPlot::SetupAxisLimits (ImAxis_X1, 0.0, history_size, ImPlotCond_Always);
+    ImPlot::PlotLine (label, h.values.data (), h.count, 1.0, 0.0, h.offset ());
+    ImPlot::EndPlot ();
+}
+
+void record_frame (const clock::duration frame_time)
+{
+    s_frames.push (to_ms (frame_time));
+}
+
+void record_tick (const clock::duration tick_time)
+{
+    s_ticks.push (to_ms (tick_time));
+}
+
+void record_allocations (const alloc::counts &frame)
+{
+    s_last_allocations = frame;
+    s_allocations.push (static_cast <float> (frame.allocations));
+}
+
+void draw ()
+{
+    gather_zones ();
+
+    ImGui::SetNextWindowPos ({10.0f, 10.0f}, ImGuiCond_FirstUseEver);
+    ImGui::SetNextWindowSize ({480.0f, 0.0f}, ImGuiCond_FirstUseEver);
+    ImGui::SetNextWindowBgAlpha (0.8f);
+    if (! ImGui::Begin ("Profiler", nullptr, ImGuiWindowFlags_NoFocusOnAppearing | ImGuiWindowFlags_NoNav))
+    {
+        ImGui::End ();
+        return;
+    }
+
+    ImGui::Text ("Frame %.2f ms (%.0f fps) | Tick %.2f ms of %.2f ms (%u tps)",
+                 s_frames.last (), fost::runtime::fps (), s_ticks.last (),
+                 to_ms (fost::runtime::tick_interval ()), static_cast <unsigned int> (fost::runtime::tps ()));
+    if (gpu::is_available ())
+    {
+        // Whichever side is close to the frame time is the bottleneck.
+        ImGui::Text ("GPU %.2f ms | %llu late results dropped", to_ms (gpu::last_frame_time ()),
+                     static_cast <unsigned long long> (gpu::dropped ()));
+    }
+
+    const auto tick_load = fost::runtime::tick_statistics ();
+    ImGui::Text ("Tick load %.0f%% | %llu over budget | %llu skipped | time scale %.2f%s",
+                 tick_load.load * 100.0f, static_cast <unsigned long long> (tick_load.over_budget),
+                 static_cast <unsigned long long> (tick_load.skipped), tick_load.time_scale,
+                 tick_load.overloaded ? " | OVERLOADED" : "");
+
+    if (fost::runtime::frame_cap () > 0.0f)
+    {
+        const auto pacing = fost::runtime::pacing_error ();
+        ImGui::Text ("Cap %.0f fps | pacing error %.3f ms, worst %.3f ms | spin %.2f ms",
+                     fost::runtime::frame_cap (), to_ms (pacing.mean), to_ms (pacing.worst), to_ms (pacing.spin));
+    }
+
+    const auto stats = fost::runtime::frame_percentiles ();
+    ImGui::Text ("p50 %.2f | p95 %.2f | p99 %.2f | p99.9 %.2f ms | 1%% low %.0f fps",
+                 to_ms (stats.p50), to_ms (stats.p95), to_ms (stats.p99), to_ms (stats.p999),
+                 stats.low_1_percent_fps);
+
+    if (quality::target_frame_time () > clock::duration {0})
+    {
+        ImGui::Text ("Quality for %.2f ms, pressure %.2f:", to_ms (quality::target_frame_time ()), quality::pressure ());
+        for (quality::knob_id id = 0U; id < quality::knob_count (); ++id)
+        {
+            const quality::knob_info k = quality::knob (id);
+            ImGui::SameLine ();
+            ImGui::Text ("%s %u/%u", k.name, k.level + 1U, k.levels);
+        }
+    }
+
+    draw_history ("##frame_history", "frame", s_frames);
+    draw_history ("##tick_history", "tick", s_ticks);
+
+    ImGui::Separator ();
+    draw_flame_graph ();
+    draw_counters ();
+    draw_allocations ();
+
+    ImGui::End ();
+}
+
+} // namespace profiler_panel
+} // namespace fost
@@ -0,0 +1,465 @@
+#include <core/profiler_stream.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <core/capture.hpp>
+#include <core/capture_format.hpp>
+#include <core/cpu_profiler.hpp>
+#include <core/sampler.hpp>
+#include <core/spsc_queue.hpp>
+
+#if defined (__unix__) || defined (__APPLE__)
+    #define FOST_HAS_UNIX_SOCKETS
+    #include <fcntl.h>
+    #include <poll.h>
+    #include <sys/socket.h>
+    #include <sys/stat.h>
+    #include <sys/un.h>
+    #include <unistd.h>
+#endif
+
+namespace fost
+{
+namespace stream
+{
+
+namespace // anonymous
+{
+
+// Each record carries the viewer session it was recorded for, so records
+// left over from a previous viewer are skipped instead of sent.
+struct record
+{
+    capture::chunk_type type;
+    std::uint32_t session;
+    union
+    {
+        capture::frame_entry frame;
+        capture::tick_entry tick;
+        capture::zone_entry zone;
+    };
+};
+
+// A thread or zone name, sent before the first zone that refers to it.
+struct name_record
+{
+    capture::chunk_type type;
+    std::uint32_t session;
+    std::uint32_t id;
+    // Longer names are cut short.
+    char text[52];
+};
+
+// Records queued between the game and the sender thread.
+constexpr std::size_t s_queue_capacity = 1U << 14;
+constexpr std::size_t s_names_capacity = 1U << 10;
+
+// How often the sender wakes up to flush the queue to the viewer.
+constexpr auto s_send_interval = 10ms;
+
+// A viewer that takes no bytes for this long is hung and gets disconnected.
+constexpr auto s_stall_timeout = 2s;
+
+} // namespace anonymous
+
+// Written by the game thread alone, which overwrites the oldest records when
+// the sender falls behind. The sender notices and drops those, so neither
+// side ever waits for the other.
+static std::array <record, s_queue_capacity> s_queue;
+static std::atomic <std::uint64_t> s_head {0U};
+// Names get a queue of their own, as zones are useless without them. There
+// are only a few hundred, so it does not fill up in practice.
+static spsc_queue <name_record, s_names_capacity> s_names;
+
+static std::atomic <bool> s_running {false};
+static std::atomic <bool> s_connected {false};
+// Bumped by the sender for every viewer, so the game side knows to resend names.
+static std::atomic <std::uint32_t> s_session {0U};
+static std::atomic <std::uint64_t> s_dropped {0U};
+
+static std::thread s_sender;
+static std::string s_path;
+static int s_listen_fd = -1;
+static clock::rep s_origin = 0;
+
+// Only touched by the thread recording frames.
+static capture::zone_collector s_collector;
+static std::uint32_t s_synced_session = 0U;
+
+static void push (record r)
+{
+    r.session = s_synced_session;
+    const std::uint64_t head = s_head.load (std::memory_order_relaxed);
+    s_queue[head & (s_queue_capacity - 1)] = r;
+    s_head.store (head + 1, std::memory_order_release);
+}
+
+static void push_name (const capture::chunk_type type, const std::uint32_t id, const std::string_view text)
+{
+    name_record n {type, s_synced_session, id, {}};
+    std::memcpy (n.text, text.data (), std::min (text.size (), sizeof (n.text) - 1U));
+    if (! s_names.try_push (n))
+        s_dropped.fetch_add (1U, std::memory_order_relaxed);
+}
+
+// Returns false while nobody listens. When a new viewer connected, restarts
+// name interning for it.
+static const bool sync ()
+{
+    if (! s_connected.load (std::memory_order_acquire))
+        return false;
+
+    const std::uint32_t session = s_session.load (std::memory_order_acquire);
+    if (session != s_synced_session)
+    {
+        s_collector.reset (s_origin);
+        s_synced_session = session;
+    }
+    return true;
+}
+
+#ifdef FOST_HAS_UNIX_SOCKETS
+
+#ifdef MSG_NOSIGNAL
+static constexpr int s_send_flags = MSG_NOSIGNAL;
+#else
+static constexpr int s_send_flags = 0;
+#endif
+
+// Never blocks for long, so a viewer that stops reading cannot hold up
+// stop (): it notices stop () within one poll and gives up on the viewer
+// after s_stall_timeout.
+static const bool send_all (const int fd, const char *data, std::size_t size)
+{
+    clock::time_point progress = clock::now ();
+    while (size)
+    {
+        const ssize_t sent = ::send (fd, data, size, s_send_flags | MSG_DONTWAIT);
+        if (sent > 0)
+        {
+            data += sent;
+            size -= static_cast <std::size_t> (sent);
+            progress = clock::now ();
+            continue;
+        }
+        if (sent == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+            return false;
+
+        if (! s_running.load (std::memory_order_relaxed))
+            return false;
+        if (clock::now () - progress >= s_stall_timeout)
+        {
+            std::cerr << "warn: profiler viewer stopped reading, disconnecting it\n";
+            return false;
+        }
+        pollfd pfd {fd, POLLOUT, 0};
+        ::poll (&pfd, 1, 100);
+    }
+    return true;
+}
+
+static void append_chunk (std::vector <char> &out, const capture::chunk_type type,
+                          const std::uint32_t count, const void *data, const std::size_t bytes)
+{
+    if (! count)
+        return;
+
+    const capture::chunk_header header {type, count, bytes};
+    const std::size_t offset = out.size ();
+    out.resize (offset + sizeof (header) + bytes);
+    std::memcpy (out.data () + offset, &header, sizeof (header));
+    std::memcpy (out.data () + offset + sizeof (header), data, bytes);
+}
+
+// Copies the records of session queued since tail into batch, and moves tail
+// past them. Records the game overwrote before or while they were copied are
+// dropped.
+static void take (std::uint64_t &tail, const std::uint64_t head, const std::uint32_t session,
+                  std::vector <record> &batch)
+{
+    // The game may be writing record head right now, over head - capacity.
+    std::uint64_t first = tail;
+    if (head - first >= s_queue_capacity)
+        first = head - s_queue_capacity + 1U;
+
+    const std::size_t start = batch.size ();
+    for (std::uint64_t i = first; i < head; ++i)
+        batch.push_back (s_queue[i & (s_queue_capacity - 1)]);
+
+    // Same for every record it wrote while we were copying.
+    std::atomic_thread_fence (std::memory_order_acquire);
+    const std::uint64_t lapped = s_head.load (std::memory_order_relaxed);
+    std::uint64_t torn = 0U;
+    if (lapped - first >= s_queue_capacity)
+    {
+        torn = std::min <std::uint64_t> (lapped - s_queue_capacity - first + 1U, head - first);
+        batch.erase (batch.begin () + start, batch.begin () + start + torn);
+    }
+
+    std::erase_if (batch, [session] (const record &r) { return (r.session != session); });
+    s_dropped.fetch_add ((first - tail) + torn, std::memory_order_relaxed);
+    tail = head;
+}
+
+// Appends one chunk per run of same typed records.
+static void append_records (std::vector <char> &out, const std::vector <record> &batch)
+{
+    std::size_t i = 0;
+    while (i < batch.size ())
+    {
+        const capture::chunk_type type = batch[i].type;
+        const std::size_t entry_size =
+            (type == capture::chunk_type::frames) ? sizeof (capture::frame_entry) :
+            (type == capture::chunk_type::ticks) ? sizeof (capture::tick_entry) :
+            sizeof (capture::zone_entry);
+
+        std::size_t end = i;
+        while (end < batch.size () && batch[end].type == type)
+            ++end;
+
+        const std::uint32_t count = static_cast <std::uint32_t> (end - i);
+        const capture::chunk_header header {type, count, count * entry_size};
+        std::size_t offset = out.size ();
+        out.resize (offset + sizeof (header) + header.bytes);
+        std::memcpy (out.data () + offset, &header, sizeof (header));
+        offset += sizeof (header);
+        for (; i < end; ++i, offset += entry_size)
+            std::memcpy (out.data () + offset, &batch[i].frame, entry_size);
+    }
+}
+
+static void serve_viewer (const int fd)
+{
+    const capture::file_header header = capture::make_header (s_origin);
+    if (! send_all (fd, reinterpret_cast <const char*> (&header), sizeof (header)))
+        return;
+
+    std::uint64_t tail = s_head.load (std::memory_order_acquire);
+    const std::uint32_t session = s_session.fetch_add (1U, std::memory_order_acq_rel) + 1U;
+    s_connected.store (true, std::memory_order_release);
+
+    std::vector <record> batch;
+    batch.reserve (s_queue_capacity);
+    std::vector <char> threads, names, out;
+    std::uint32_t threads_count = 0U, names_count = 0U;
+
+    while (s_running.load (std::memory_order_relaxed))
+    {
+        std::this_thread::sleep_for (s_send_interval);
+
+        // Every name a record up to head refers to was queued before it.
+        const std::uint64_t head = s_head.load (std::memory_order_acquire);
+        name_record n;
+        while (s_names.try_pop (n))
+        {
+            if (n.session != session)
+                continue;
+            const bool thread = (n.type == capture::chunk_type::threads);
+            capture::append_name (thread ? threads : names, n.id, n.text);
+            ++(thread ? threads_count : names_count);
+        }
+
+        batch.clear ();
+        take (tail, head, session, batch);
+
+        // Names first, the zones after them may refer to them.
+        out.clear ();
+        append_chunk (out, capture::chunk_type::threads, threads_count, threads.data (), threads.size ());
+        append_chunk (out, capture::chunk_type::names, names_count, names.data (), names.size ());
+        append_records (out, batch);
+        threads.clear ();
+        threads_count = 0U;
+        names.clear ();
+        names_count = 0U;
+
+        if (! out.empty () && ! send_all (fd, out.data (), out.size ()))
+            break;
+    }
+
+    s_connected.store (false, std::memory_order_release);
+}
+
+static void serve ()
+{
+    fost::set_thread_name ("Profiler stream");
+    fost::sampler::register_thread ();
+
+    while (s_running.load (std::memory_order_relaxed))
+    {
+        pollfd pfd {s_listen_fd, POLLIN, 0};
+        if (::poll (&pfd, 1, 100) <= 0)
+            continue;
+
+        const int fd = ::accept (s_listen_fd, nullptr, nullptr);
+        if (fd < 0)
+            continue;
+
+        std::cout << "Profiler viewer connected.\n";
+        serve_viewer (fd);
+        ::close (fd);
+        std::cout << "Profiler viewer disconnected.\n";
+    }
+}
+
+// Makes way for a socket at addr. Only a socket file left behind by a run
+// that crashed is removed: a socket still accepting connections belongs to
+// another instance, and anything else at the path is not ours, so both make
+// this return false.
+static const bool remove_stale_socket (const sockaddr_un &addr)
+{
+    struct stat st;
+    if (::lstat (addr.sun_path, &st) != 0)
+        return (errno == ENOENT);
+    if (! S_ISSOCK (st.st_mode))
+        return false;
+
+    // Non-blocking, as a live instance with a full backlog would hold up connect.
+    const int fd = ::socket (AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+        return false;
+    ::fcntl (fd, F_SETFL, ::fcntl (fd, F_GETFL) | O_NONBLOCK);
+    const bool stale = (::connect (fd, reinterpret_cast <const sockaddr*> (&addr), sizeof (addr)) != 0
+                        && errno == ECONNREFUSED);
+    ::close (fd);
+    return stale && ::unlink (addr.sun_path) == 0;
+}
+
+const bool start (const std::string &path)
+{
+    stop ();
+
+    sockaddr_un addr {};
+    if (path.size () >= sizeof (addr.sun_path))
+        return false;
+    addr.sun_family = AF_UNIX;
+    std::memcpy (addr.sun_path, path.c_str (), path.size () + 1);
+
+    if (! remove_stale_socket (addr))
+    {
+        std::cerr << "warn: " << path << " is in use or not a socket, not replacing it\n";
+        return false;
+    }
+
+    s_listen_fd = ::socket (AF_UNIX, SOCK_STREAM, 0);
+    if (s_listen_fd < 0)
+        return false;
+
+    if (::bind (s_listen_fd, reinterpret_cast <const sockaddr*> (&addr), sizeof (addr)) != 0
+        || ::listen (s_listen_fd, 1) != 0)
+    {
+        ::close (s_listen_fd);
+        s_listen_fd = -1;
+        return false;
+    }
+
+    s_path = path;
+    s_origin = profiler_now ();
+    s_dropped.store (0U, std::memory_order_relaxed);
+    s_running.store (true, std::memory_order_relaxed);
+    s_sender = std::thread {serve};
+    return true;
+}
+
+void stop ()
+{
+    if (! s_running.exchange (false))
+        return;
+
+    s_sender.join ();
+    ::close (s_listen_fd);
+    s_listen_fd = -1;
+    ::unlink (s_path.c_str ());
+}
+
+#else
+
+const bool start (const std::string &path)
+{
+    return false;
+}
+
+void stop ()
+{
+}
+
+#endif // FOST_HAS_UNIX_SOCKETS
+
+const std::string default_socket_path ()
+{
+    const char *runtime_dir = std::getenv ("XDG_RUNTIME_DIR");
+    return std::string {(runtime_dir && *runtime_dir) ? runtime_dir : "/tmp"} + "/blockytry-profiler.sock";
+}
+
+const bool is_listening ()
+{
+    return s_running.load (std::memory_order_relaxed);
+}
+
+const bool is_connected ()
+{
+    return s_connected.load (std::memory_order_relaxed);
+}
+
+void record_frame (const clock::time_point begin, const clock::duration duration, const std::uint32_t ticks,
+                   const alloc::counts &allocations)
+{
+    if (! sync ())
+        return;
+
+    record r {capture::chunk_type::frames, 0U, {}};
+    r.frame = capture::make_frame (s_origin, begin, duration, ticks, allocations);
+    push (r);
+}
+
+void record_tick (const clock::time_point begin, const clock::duration duration)
+{
+    if (! sync ())
+        return;
+
+    record r {capture::chunk_type::ticks, 0U, {}};
+    r.tick = {capture::relative_ns (s_origin, begin.time_since_epoch ().count ()),
+              std::chrono::duration_cast <std::chrono::nanoseconds> (duration).count ()};
+    push (r);
+}
+
+void collect_zones ()
+{
+    if (! sync ())
+        return;
+
+    s_collector.collect (
+        [] (const std::uint32_t id, const std::string &name)
+        {
+            push_name (capture::chunk_type::threads, id, name);
+        },
+        [] (const std::uint32_t id, const char *name)
+        {
+            push_name (capture::chunk_type::names, id, name);
+        },
+        [] (const capture::zone_entry &zone)
+        {
+            record r {capture::chunk_type::zones, 0U, {}};
+            r.zone = zone;
+            push (r);
+        });
+}
+
+const std::uint64_t dropped ()
+{
+    return s_dropped.load (std::memory_order_relaxed);
+}
+
+} // namespace stream
+} // namespace fost
@@ -0,0 +1,156 @@
+#include <core/quality.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <core/tick_governor.hpp>
+
+namespace fost
+{
+namespace quality
+{
+
+namespace // anonymous
+{
+
+struct knob_entry
+{
+    knob_info info;
+    apply_fn apply;
+};
+
+// Frames measured before each decision. Only frames since the last change
+// count, so a decision never sees frames rendered at another quality.
+constexpr std::size_t window = 60U;
+constexpr std::size_t percentile_rank = window * 95U / 100U;
+
+// Hysteresis: lower as soon as one window misses the target by more than
+// lower_above, raise only after raise_after windows all under raise_below.
+constexpr float lower_above = 1.05f;
+constexpr float raise_below = 0.8f;
+constexpr std::uint32_t raise_after = 3U;
+
+} // namespace anonymous
+
+static std::vector <knob_entry> s_knobs;
+static clock::duration s_target {0};
+static std::array <clock::duration, window> s_frames {};
+static std::size_t s_measured = 0U;
+static std::uint32_t s_good_windows = 0U;
+static float s_pressure = 0.0f;
+
+knob_id add_knob (const char *name, const std::uint32_t levels, const std::uint32_t initial,
+                  const int priority, apply_fn apply)
+{
+    const std::uint32_t count = std::max (levels, 1U);
+    s_knobs.push_back ({{name, count, std::min (initial, count - 1U), priority}, std::move (apply)});
+    knob_entry &k = s_knobs.back ();
+    if (k.apply)
+        k.apply (k.info.level);
+    return static_cast <knob_id> (s_knobs.size () - 1U);
+}
+
+static void move (knob_entry &k, const std::uint32_t level)
+{
+    if (k.info.level == level)
+        return;
+
+    k.info.level = level;
+    if (k.apply)
+        k.apply (level);
+
+    // Start measuring afresh at the new quality.
+    s_measured = 0U;
+}
+
+void set_level (const knob_id id, const std::uint32_t level)
+{
+    if (id < s_knobs.size ())
+        move (s_knobs[id], std::min (level, s_knobs[id].info.levels - 1U));
+}
+
+const std::size_t knob_count ()
+{
+    return s_knobs.size ();
+}
+
+const knob_info knob (const knob_id id)
+{
+    return s_knobs[id].info;
+}
+
+void set_target_frame_time (const clock::duration target)
+{
+    s_target = std::max (target, clock::duration {0});
+    s_measured = 0U;
+    s_good_windows = 0U;
+}
+
+const clock::duration target_frame_time ()
+{
+    return s_target;
+}
+
+// Cheapest first when lowering, most important first when raising; earlier
+// registered knobs win ties.
+static knob_entry * pick (const bool lower)
+{
+    knob_entry *best = nullptr;
+    for (knob_entry &k : s_knobs)
+    {
+        const bool movable = lower ? (k.info.level > 0U) : (k.info.level + 1U < k.info.levels);
+        if (! movable)
+            continue;
+        if (! best || (lower ? (k.info.priority < best->info.priority) : (k.info.priority > best->info.priority)))
+            best = &k;
+    }
+    return best;
+}
+
+void update (const clock::duration work)
+{
+    if (s_target == clock::duration {0} || s_knobs.empty ())
+        return;
+
+    s_frames[s_measured++] = work;
+    if (s_measured < window)
+        return;
+    s_measured = 0U;
+
+    std::nth_element (s_frames.begin (), s_frames.begin () + percentile_rank, s_frames.end ());
+    const float frame_pressure = std::chrono::duration <float> {s_frames[percentile_rank]} / s_target;
+
+    // Ticks run on their own thread, but a client whose ticks overrun is
+    // just as starved of CPU as one whose frames do.
+    const float tick_pressure = runtime::tick_statistics ().load / runtime::governor ().budget;
+    s_pressure = std::max (frame_pressure, tick_pressure);
+
+    if (s_pressure > lower_above)
+    {
+        s_good_windows = 0U;
+        if (knob_entry *k = pick (true))
+            move (*k, k->info.level - 1U);
+    }
+    else if (s_pressure < raise_below)
+    {
+        if (++s_good_windows < raise_after)
+            return;
+        s_good_windows = 0U;
+        if (knob_entry *k = pick (false))
+            move (*k, k->info.level + 1U);
+    }
+    else
+        s_good_windows = 0U;
+}
+
+const float pressure ()
+{
+    return s_pressure;
+}
+
+} // namespace quality
+} // namespace fost
@@ -1,8 +1,13 @@
 #include <core/runtime.hpp>
 
+#include <algorithm>
+#include <array>
+#include <bit>
 #include <cassert>
 #include <chrono>
 #include <cstddef>
+#include <cstdint>
+#include <thread>
 
 namespace fost
 {
@@ -24,6 +29,87 @@ static duration s_frametime = zero;
 // Frames per second.
 static float s_fps = 0.0f;
 
+// Frame pacing, off while the interval is zero.
+static float s_frame_cap = 0.0f;
+static clock::duration s_frame_interval {0};
+static clock::time_point s_next_frame {};
+
+// Sleep is trusted up to this far before the slot, the rest is spun. Grows
+// at once when a sleep overshoots more, shrinks slowly when sleeps are good.
+static clock::duration s_spin_margin = std::chrono::microseconds {1000};
+constexpr clock::duration min_spin_margin = std::chrono::microseconds {100};
+constexpr clock::duration max_spin_margin = std::chrono::microseconds {4000};
+
+constexpr std::size_t pacing_window = 128U;
+static std::array <clock::duration, pacing_window> s_pacing_errors {};
+static std::size_t s_paced = 0U;
+
+namespace // anonymous
+{
+
+// Log-linear histogram of frame times in microseconds, in the spirit of
+// HdrHistogram: values below 2^sub_bits are exact, above that every power of
+// two is split into 2^sub_bits buckets. Times are clamped to 2^26 us (~67 s).
+constexpr std::uint32_t sub_bits = 5U;
+constexpr std::uint32_t sub_count = 1U << sub_bits;
+constexpr std::uint32_t max_bits = 26U;
+constexpr std::uint32_t bucket_count = (max_bits - sub_bits + 1U) * sub_count;
+
+constexpr std::uint32_t bucket_of (std::uint32_t us)
+{
+    us = std::min (us, (1U << max_bits) - 1U);
+    if (us < sub_count)
+        return us;
+    const std::uint32_t shift = std::bit_width (us) - 1U - sub_bits;
+    return (shift + 1U) * sub_count + ((us >> shift) - sub_count);
+}
+
+// Middle of the range a bucket covers, in microseconds.
+constexpr double bucket_value (const std::uint32_t bucket)
+{
+    if (bucket < 2U * sub_count)
+        return bucket;
+    const std::uint32_t shift = bucket / sub_count - 1U;
+    const std::uint32_t low = (sub_count + bucket % sub_count) << shift;
+    return low + ((1U << shift) - 1U) / 2.0;
+}
+
+static_assert (bucket_of (31U) == 31U && bucket_of (63U) == 63U && bucket_of (64U) == 64U);
+static_assert (bucket_of (~0U) == bucket_count - 1U);
+
+struct histogram
+{
+    std::array <std::uint32_t, bucket_count> counts {};
+    std::size_t length;     // Window size in frames.
+    std::size_t frames = 0; // Frames currently counted, up to length.
+};
+
+} // namespace anonymous
+
+// Buckets of the last max_stats_window frames, shared by all windows. Each
+// window forgets the frame that falls out of it, so updates are O(1).
+static std::array <std::uint16_t, max_stats_window> s_recent_buckets {};
+static std::size_t s_recorded = 0U;
+static std::array <histogram, 2> s_windows {{ {{}, 256U}, {{}, 8192U} }};
+
+static void record_frame_time (const duration frametime)
+{
+    const auto us = std::chrono::duration_cast <std::chrono::microseconds> (frametime).count ();
+    const std::uint32_t bucket = bucket_of (static_cast <std::uint32_t> (std::max <decltype (us)> (us, 0)));
+
+    for (histogram &h : s_windows)
+    {
+        if (h.frames == h.length)
+            --h.counts[s_recent_buckets[(s_recorded - h.length) % max_stats_window]];
+        else
+            ++h.frames;
+        ++h.counts[bucket];
+    }
+
+    s_recent_buckets[s_recorded % max_stats_window] = static_cast <std::uint16_t> (bucket);
+    ++s_recorded;
+}
+
 void cycle ()
 {
     const time_point now = clock::now ();
@@ -36,6 +122,7 @@ void cycle ()
     s_fps = 1.0f / std::chrono::duration <float> (s_frametime).count ();
 #endif
     s_last_frame = now;
+    record_frame_time (s_frametime);
 }
 
 const system_clock::time_point beginning ()
@@ -68,6 +155,122 @@ const float fps ()
     return s_fps;
 }
 
+void set_stats_window (const stats_window window, const std::size_t frames)
+{
+    histogram &h = s_windows[static_cast <std::size_t> (window)];
+    h.length = std::clamp <std::size_t> (frames, 1U, max_stats_window);
+    h.frames = std::min (h.length, std::min (s_recorded, max_stats_window));
+    h.counts.fill (0U);
+    for (std::size_t i = s_recorded - h.frames; i < s_recorded; ++i)
+        ++h.counts[s_recent_buckets[i % max_stats_window]];
+}
+
+const frame_stats frame_percentiles (const stats_window window)
+{
+    const histogram &h = s_windows[static_cast <std::size_t> (window)];
+    frame_stats stats {zero, zero, zero, zero, 0.0f, h.frames};
+    if (! h.frames)
+        return stats;
+
+    const auto to_duration = [] (const double us)
+    {
+        return std::chrono::duration_cast <duration> (std::chrono::duration <double, std::micro> {us});
+    };
+
+    // Smallest bucket holding at least the given rank.
+    const std::array <double, 4> quantiles {0.5, 0.95, 0.99, 0.999};
+    std::array <duration*, 4> results {&stats.p50, &stats.p95, &stats.p99, &stats.p999};
+    std::size_t seen = 0U;
+    std::size_t q = 0U;
+    for (std::uint32_t b = 0U; b < bucket_count && q < quantiles.size (); ++b)
+    {
+        seen += h.counts[b];
+        while (q < quantiles.size () && seen >= static_cast <std::size_t> (quantiles[q] * h.frames + 0.5) && seen)
+            *results[q++] = to_duration (bucket_value (b));
+    }
+
+    // Mean of the slowest 1%, walking down from the top.
+    const std::size_t slowest = std::max <std::size_t> (1U, h.frames / 100U);
+    std::size_t taken = 0U;
+    double total_us = 0.0;
+    for (std::uint32_t b = bucket_count; b-- > 0U && taken < slowest;)
+    {
+        const std::size_t n = std::min <std::size_t> (h.counts[b], slowest - taken);
+        total_us += n * bucket_value (b);
+        taken += n;
+    }
+    if (total_us > 0.0)
+        stats.low_1_percent_fps = static_cast <float> (1e6 * taken / total_us);
+
+    return stats;
+}
+
+void set_tps (const std::uint16_t rate)
+{
+    const std::uint16_t clamped = std::clamp (rate, min_tps, max_tps);
+    detail::s_tick_interval.store ((duration {1s} / clamped).count (), std::memory_order_relaxed);
+    detail::s_tps.store (clamped, std::memory_order_relaxed);
+}
+
+void set_frame_cap (const float fps)
+{
+    s_frame_cap = std::max (fps, 0.0f);
+    s_frame_interval = (s_frame_cap > 0.0f)
+        ? std::chrono::duration_cast <clock::duration> (std::chrono::duration <double> {1.0 / s_frame_cap})
+        : clock::duration {0};
+    s_next_frame = {};
+    s_paced = 0U;
+}
+
+const float frame_cap ()
+{
+    return s_frame_cap;
+}
+
+void pace_frame ()
+{
+    if (s_frame_interval == clock::duration {0})
+        return;
+
+    const clock::time_point now = clock::now ();
+    if (s_next_frame == clock::time_point {} || now - s_next_frame > s_frame_interval)
+        s_next_frame = now;
+
+    const clock::time_point wake = s_next_frame - s_spin_margin;
+    if (now < wake)
+    {
+        std::this_thread::sleep_until (wake);
+        const clock::duration overslept = clock::now () - wake;
+        const clock::duration wanted = std::clamp (overslept + overslept / 4, min_spin_margin, max_spin_margin);
+        s_spin_margin = (wanted > s_spin_margin) ? wanted : s_spin_margin - (s_spin_margin - wanted) / 16;
+    }
+
+    clock::time_point started = clock::now ();
+    while (started < s_next_frame)
+        started = clock::now ();
+
+    s_pacing_errors[s_paced % pacing_window] = started - s_next_frame;
+    ++s_paced;
+    s_next_frame += s_frame_interval;
+}
+
+const pacing_stats pacing_error ()
+{
+    pacing_stats stats {zero, zero, zero, s_spin_margin};
+    if (! s_paced)
+        return stats;
+
+    const std::size_t count = std::min (s_paced, pacing_window);
+    clock::duration total {0};
+    for (std::size_t i = 0U; i < count; ++i)
+    {
+        total += s_pacing_errors[i];
+        stats.worst = std::max <duration> (stats.worst, s_pacing_errors[i]);
+    }
+    stats.last = s_pacing_errors[(s_paced - 1U) % pacing_window];
+    stats.mean = total / count;
+    return stats;
+}
 
 } // namespace runtime
 } // namespace fost
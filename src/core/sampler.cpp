@@ -0,0 +1,428 @@
+#include <core/sampler.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <core/cpu_profiler.hpp>
+
+#ifdef __linux__
+    #include <cerrno>
+    #include <csignal>
+    #include <ctime>
+    #include <cxxabi.h>
+    #include <dlfcn.h>
+    #include <pthread.h>
+    #include <sys/syscall.h>
+    #include <ucontext.h>
+    #include <unistd.h>
+
+    // Older glibc only exposes the union member.
+    #ifndef sigev_notify_thread_id
+        #define sigev_notify_thread_id _sigev_un._tid
+    #endif
+#endif
+
+namespace fost
+{
+namespace sampler
+{
+
+static std::atomic <bool> s_running {false};
+static std::atomic <std::uint64_t> s_samples {0U};
+static std::atomic <std::uint64_t> s_dropped {0U};
+
+#ifdef __linux__
+
+namespace // anonymous
+{
+
+// Deepest stack kept per sample, frames past it are cut off at the root.
+constexpr int max_frames = 64;
+
+// Samples buffered per thread between two collect () calls.
+constexpr std::size_t ring_capacity = 1U << 11;
+
+struct stack_sample
+{
+    int depth;
+    void *frames[max_frames];
+};
+
+struct transparent_hash
+{
+    using is_transparent = void;
+
+    std::size_t operator() (const std::string_view key) const
+    {
+        return std::hash <std::string_view> {} (key);
+    }
+};
+
+// Single producer (the signal handler on the owning thread), single consumer
+// (collect, under s_mutex). The handler never overwrites unread samples, it
+// drops new ones instead.
+struct sample_ring
+{
+    std::unique_ptr <stack_sample[]> samples {new stack_sample[ring_capacity]};
+    std::atomic <std::uint64_t> head {0U};
+    std::atomic <std::uint64_t> tail {0U};
+
+    std::string thread_name;
+    timer_t timer {};
+    bool armed = false;
+
+    // Bounds of the thread's stack, frame pointers outside it end the walk.
+    std::uintptr_t stack_low = 0U;
+    std::uintptr_t stack_high = 0U;
+
+    // Raw frame addresses to hit count, only touched under s_mutex.
+    std::unordered_map <std::string, std::uint64_t, transparent_hash, std::equal_to <>> stacks;
+};
+
+// Disarms the thread's timer when it exits. The ring stays registered, its
+// samples still belong in the output.
+struct thread_guard
+{
+    ~thread_guard ();
+};
+
+} // namespace anonymous
+
+static std::mutex s_mutex;
+static std::vector <std::unique_ptr <sample_ring>> s_rings;
+static std::chrono::microseconds s_interval {1000};
+
+static thread_local sample_ring *tl_ring = nullptr;
+
+// Program counter, frame pointer and stack pointer of the interrupted code.
+static const bool interrupted_registers (const void *context, std::uintptr_t &pc,
+                                         std::uintptr_t &fp, std::uintptr_t &sp)
+{
+    const ucontext_t *uc = static_cast <const ucontext_t*> (context);
+#if defined (__x86_64__)
+    pc = static_cast <std::uintptr_t> (uc->uc_mcontext.gregs[REG_RIP]);
+    fp = static_cast <std::uintptr_t> (uc->uc_mcontext.gregs[REG_RBP]);
+    sp = static_cast <std::uintptr_t> (uc->uc_mcontext.gregs[REG_RSP]);
+    return true;
+#elif defined (__aarch64__)
+    pc = static_cast <std::uintptr_t> (uc->uc_mcontext.pc);
+    fp = static_cast <std::uintptr_t> (uc->uc_mcontext.regs[29]);
+    sp = static_cast <std::uintptr_t> (uc->uc_mcontext.sp);
+    return true;
+#else
+    return false;
+#endif
+}
+
+// Follows the frame pointer chain up from the interrupted code. Only reads
+// memory inside the thread's stack, so it is async-signal-safe, unlike
+// backtrace (), which may take loader locks or allocate. Frames compiled
+// without frame pointers end the walk early or are skipped over.
+static const int walk_stack (const sample_ring &ring, const void *context, void **frames)
+{
+    std::uintptr_t pc = 0U;
+    std::uintptr_t fp = 0U;
+    std::uintptr_t sp = 0U;
+    if (! interrupted_registers (context, pc, fp, sp))
+        return 0;
+
+    int depth = 0;
+    frames[depth++] = reinterpret_cast <void*> (pc);
+    if (ring.stack_high == 0U)
+        return depth;
+
+    // Each frame starts with the caller's frame pointer, then the return
+    // address. Frames grow down, so every caller's frame sits higher.
+    std::uintptr_t low = std::max (sp, ring.stack_low);
+    while (depth < max_frames)
+    {
+        if (fp < low || fp > ring.stack_high - 2U * sizeof (void*) || fp % sizeof (void*) != 0U)
+            break;
+
+        const std::uintptr_t *frame = reinterpret_cast <const std::uintptr_t*> (fp);
+        const std::uintptr_t return_address = frame[1];
+        if (return_address == 0U)
+            break;
+
+        frames[depth++] = reinterpret_cast <void*> (return_address);
+        low = fp + 2U * sizeof (void*);
+        fp = frame[0];
+    }
+    return depth;
+}
+
+static void on_sigprof (int, siginfo_t*, void *context)
+{
+    sample_ring *ring = tl_ring;
+    if (! ring || ! s_running.load (std::memory_order_relaxed))
+        return;
+
+    const int saved_errno = errno;
+
+    const std::uint64_t head = ring->head.load (std::memory_order_relaxed);
+    if (head - ring->tail.load (std::memory_order_acquire) == ring_capacity)
+    {
+        s_dropped.fetch_add (1U, std::memory_order_relaxed);
+        errno = saved_errno;
+        return;
+    }
+
+    stack_sample &sample = ring->samples[head & (ring_capacity - 1)];
+    sample.depth = walk_stack (*ring, context, sample.frames);
+    ring->head.store (head + 1, std::memory_order_release);
+    s_samples.fetch_add (1U, std::memory_order_relaxed);
+
+    errno = saved_errno;
+}
+
+static void disarm (sample_ring &ring)
+{
+    if (! ring.armed)
+        return;
+
+    ::timer_delete (ring.timer);
+    ring.armed = false;
+}
+
+thread_guard::~thread_guard ()
+{
+    sample_ring *ring = tl_ring;
+    tl_ring = nullptr;
+    if (! ring)
+        return;
+
+    std::lock_guard <std::mutex> lock {s_mutex};
+    disarm (*ring);
+}
+
+const bool start (const std::chrono::microseconds interval)
+{
+    if (s_running.load (std::memory_order_relaxed))
+        return true;
+
+    struct sigaction action {};
+    action.sa_sigaction = on_sigprof;
+    action.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset (&action.sa_mask);
+    if (::sigaction (SIGPROF, &action, nullptr) != 0)
+        return false;
+
+    s_interval = interval;
+    s_samples.store (0U, std::memory_order_relaxed);
+    s_dropped.store (0U, std::memory_order_relaxed);
+    s_running.store (true, std::memory_order_relaxed);
+    register_thread ();
+    return true;
+}
+
+void stop ()
+{
+    if (! s_running.exchange (false))
+        return;
+
+    std::lock_guard <std::mutex> lock {s_mutex};
+    for (const auto &ring : s_rings)
+        disarm (*ring);
+}
+
+void register_thread ()
+{
+    if (! s_running.load (std::memory_order_relaxed) || tl_ring)
+        return;
+
+    static thread_local thread_guard guard;
+    (void) guard;
+
+    auto ring = std::make_unique <sample_ring> ();
+    ring->thread_name = get_thread_name ();
+
+    pthread_attr_t attributes;
+    if (::pthread_getattr_np (::pthread_self (), &attributes) == 0)
+    {
+        void *stack = nullptr;
+        std::size_t size = 0U;
+        if (::pthread_attr_getstack (&attributes, &stack, &size) == 0)
+        {
+            ring->stack_low = reinterpret_cast <std::uintptr_t> (stack);
+            ring->stack_high = ring->stack_low + size;
+        }
+        ::pthread_attr_destroy (&attributes);
+    }
+
+    sigevent event {};
+    event.sigev_notify = SIGEV_THREAD_ID;
+    event.sigev_signo = SIGPROF;
+    event.sigev_notify_thread_id = static_cast <pid_t> (::syscall (SYS_gettid));
+    if (::timer_create (CLOCK_THREAD_CPUTIME_ID, &event, &ring->timer) != 0)
+    {
+        std::fprintf (stderr, "warn: failed to create sampling timer for %s (%s)\n",
+                      ring->thread_name.c_str (), std::strerror (errno));
+        return;
+    }
+    ring->armed = true;
+
+    const auto seconds = std::chrono::duration_cast <std::chrono::seconds> (s_interval);
+    const auto nanoseconds = std::chrono::duration_cast <std::chrono::nanoseconds> (s_interval - seconds);
+    itimerspec spec {};
+    spec.it_interval.tv_sec = static_cast <time_t> (seconds.count ());
+    spec.it_interval.tv_nsec = static_cast <long> (nanoseconds.count ());
+    spec.it_value = spec.it_interval;
+
+    std::lock_guard <std::mutex> lock {s_mutex};
+    tl_ring = ring.get ();
+    s_rings.push_back (std::move (ring));
+    ::timer_settime (tl_ring->timer, 0, &spec, nullptr);
+}
+
+static void drain (sample_ring &ring)
+{
+    const std::uint64_t head = ring.head.load (std::memory_order_acquire);
+    std::uint64_t tail = ring.tail.load (std::memory_order_relaxed);
+    for (; tail != head; ++tail)
+    {
+        const stack_sample &sample = ring.samples[tail & (ring_capacity - 1)];
+        if (sample.depth <= 0)
+            continue;
+
+        const std::string_view key {reinterpret_cast <const char*> (sample.frames),
+                                    sample.depth * sizeof (void*)};
+        auto stack = ring.stacks.find (key);
+        if (stack == ring.stacks.end ())
+            ring.stacks.emplace (std::string {key}, 1U);
+        else
+            ++stack->second;
+    }
+    ring.tail.store (tail, std::memory_order_release);
+}
+
+void collect ()
+{
+    std::lock_guard <std::mutex> lock {s_mutex};
+    for (const auto &ring : s_rings)
+        drain (*ring);
+}
+
+static std::string symbolize (const void *address)
+{
+    char fallback[32];
+    Dl_info info {};
+    if (! ::dladdr (address, &info))
+    {
+        std::snprintf (fallback, sizeof (fallback), "%p", address);
+        return fallback;
+    }
+
+    if (info.dli_sname)
+    {
+        int status = 0;
+        char *demangled = abi::__cxa_demangle (info.dli_sname, nullptr, nullptr, &status);
+        std::string name {(status == 0 && demangled) ? demangled : info.dli_sname};
+        std::free (demangled);
+        return name;
+    }
+
+    // Stripped or hidden symbol. Name the module only, like perf does, so all
+    // samples inside it merge into one flame graph frame.
+    const char *module = info.dli_fname ? info.dli_fname : "?";
+    if (const char *slash = std::strrchr (module, '/'))
+        module = slash + 1;
+    return std::string {"["} + module + ']';
+}
+
+const bool write_folded (const std::string &path)
+{
+    collect ();
+
+    std::ofstream f {path, std::ios::out | std::ios::trunc};
+    if (! f.good ())
+        return false;
+
+    // Stacks differing only in addresses inside the same function collapse
+    // into one line once symbolized.
+    std::unordered_map <const void*, std::string> symbols;
+    std::map <std::string, std::uint64_t> folded;
+    std::lock_guard <std::mutex> lock {s_mutex};
+    for (const auto &ring : s_rings)
+    {
+        for (const auto &[key, count] : ring->stacks)
+        {
+            const void *const *frames = reinterpret_cast <const void *const *> (key.data ());
+            const std::size_t depth = key.size () / sizeof (void*);
+
+            std::string line = ring->thread_name;
+            for (std::size_t i = depth; i-- > 0;)
+            {
+                // Past the first frame these are return addresses, step back
+                // into the call instruction so inlined callers resolve right.
+                const void *address = (i == 0) ? frames[i] : static_cast <const char*> (frames[i]) - 1;
+                auto symbol = symbols.find (address);
+                if (symbol == symbols.end ())
+                    symbol = symbols.emplace (address, symbolize (address)).first;
+                line += ';';
+                line += symbol->second;
+            }
+            folded[line] += count;
+        }
+    }
+
+    for (const auto &[line, count] : folded)
+        f << line << ' ' << count << '\n';
+    return f.good ();
+}
+
+#else
+
+const bool start (const std::chrono::microseconds interval)
+{
+    return false;
+}
+
+void stop ()
+{
+}
+
+void register_thread ()
+{
+}
+
+void collect ()
+{
+}
+
+const bool write_folded (const std::string &path)
+{
+    return false;
+}
+
+#endif // __linux__
+
+const bool is_running ()
+{
+    return s_running.load (std::memory_order_relaxed);
+}
+
+const std::uint64_t samples ()
+{
+    return s_samples.load (std::memory_order_relaxed);
+}
+
+const std::uint64_t dropped ()
+{
+    return s_dropped.load (std::memory_order_relaxed);
+}
+
+} // namespace sampler
+} // namespace fost
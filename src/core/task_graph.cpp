@@ -0,0 +1,177 @@
+#include <core/task_graph.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+#include <core/cpu_profiler.hpp>
+#include <core/jobs.hpp>
+
+namespace fost
+{
+
+void task_graph::add (const char *name, std::initializer_list <std::size_t> reads,
+                      std::initializer_list <std::size_t> writes, system_fn fn)
+{
+    system s {name, {}, {}, std::move (fn), {}, {}, true};
+    for (const std::size_t r : reads)
+    {
+        if (r < max_resources)
+            s.reads.set (r);
+        else
+            s.valid = false;
+    }
+    for (const std::size_t w : writes)
+    {
+        if (w < max_resources)
+            s.writes.set (w);
+        else
+            s.valid = false;
+    }
+
+    _systems.push_back (std::move (s));
+    _compiled = false;
+}
+
+const bool task_graph::compile ()
+{
+    _compiled = false;
+    _roots.clear ();
+
+    bool ok = true;
+    for (std::size_t i = 0; i < _systems.size (); ++i)
+    {
+        system &s = _systems[i];
+        s.successors.clear ();
+        s.predecessors.clear ();
+
+        if (! s.valid)
+        {
+            std::cerr << "Task graph: system " << s.name << " uses a resource id past " << max_resources << '\n';
+            ok = false;
+        }
+        if (! s.fn)
+        {
+            std::cerr << "Task graph: system " << s.name << " has nothing to run\n";
+            ok = false;
+        }
+        for (std::size_t j = 0; j < i; ++j)
+        {
+            if (std::strcmp (_systems[j].name, s.name) == 0)
+            {
+                std::cerr << "Task graph: system " << s.name << " added twice\n";
+                ok = false;
+            }
+        }
+    }
+    if (! ok)
+        return false;
+
+    // Edges always point from an earlier system to a later one, so the graph
+    // cannot have cycles. An edge already implied by a path through other
+    // systems, of any length, is left out.
+    //
+    // Per system, every system it waits for directly or through others.
+    // Earlier systems are visited nearest first, so by the time j is looked
+    // at every path to it through a later system is already known.
+    const std::size_t count = _systems.size ();
+    std::vector <std::vector <bool>> ancestors (count, std::vector <bool> (count, false));
+    for (std::uint32_t i = 0; i < count; ++i)
+    {
+        system &later = _systems[i];
+        std::vector <bool> &reached = ancestors[i];
+        for (std::uint32_t j = i; j-- > 0;)
+        {
+            if (reached[j])
+                continue;
+
+            const system &earlier = _systems[j];
+            const bool conflict = (earlier.writes & (later.reads | later.writes)).any ()
+                || (later.writes & earlier.reads).any ();
+            if (! conflict)
+                continue;
+
+            later.predecessors.push_back (j);
+            reached[j] = true;
+            for (std::uint32_t k = 0; k < j; ++k)
+                if (ancestors[j][k])
+                    reached[k] = true;
+        }
+
+        for (const std::uint32_t p : later.predecessors)
+            _systems[p].successors.push_back (i);
+        if (later.predecessors.empty ())
+            _roots.push_back (i);
+    }
+
+    _remaining.reset (new std::atomic <std::uint32_t>[_systems.size ()]);
+    _compiled = true;
+    return true;
+}
+
+void task_graph::run ()
+{
+    if (! _compiled)
+        return;
+
+    if (jobs::worker_count () <= 1U || jobs::this_worker () < 0)
+    {
+        for (const system &s : _systems)
+        {
+            FOST_PROFILE_ZONE_COUNTERS (s.name);
+            s.fn ();
+        }
+        return;
+    }
+
+    for (std::size_t i = 0; i < _systems.size (); ++i)
+        _remaining[i].store (static_cast <std::uint32_t> (_systems[i].predecessors.size ()), std::memory_order_relaxed);
+
+    jobs::counter done;
+    for (const std::uint32_t root : _roots)
+        submit (root, done);
+    jobs::wait (done);
+}
+
+void task_graph::submit (const std::uint32_t index, jobs::counter &done)
+{
+    jobs::run (done, [this, index, &done] () { execute (index, done); });
+}
+
+void task_graph::execute (const std::uint32_t index, jobs::counter &done)
+{
+    const system &s = _systems[index];
+    {
+        FOST_PROFILE_ZONE_COUNTERS (s.name);
+        s.fn ();
+    }
+
+    // Successors are queued before this job counts as done, so done cannot
+    // drain while work is left.
+    for (const std::uint32_t next : s.successors)
+        if (_remaining[next].fetch_sub (1U, std::memory_order_acq_rel) == 1U)
+            submit (next, done);
+}
+
+void task_graph::describe (std::ostream &os) const
+{
+    for (const system &s : _systems)
+    {
+        os << s.name;
+        if (s.predecessors.empty ())
+            os << " (root)";
+        else
+        {
+            os << " after";
+            for (const std::uint32_t p : s.predecessors)
+                os << ' ' << _systems[p].name;
+        }
+        os << '\n';
+    }
+}
+
+} // namespace fost
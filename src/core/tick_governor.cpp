@@ -0,0 +1,154 @@
+#include <core/tick_governor.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace fost
+{
+namespace runtime
+{
+
+// Weight of the newest tick in the moving averages.
+constexpr float average_weight = 1.0f / 16.0f;
+
+// Guards the config and the stats, which other threads read.
+static std::mutex s_mutex;
+static governor_config s_config;
+static tick_stats s_stats {0U, 0U, 0U, zero, zero, zero, 0.0f, 1.0f, 0U, false};
+
+// Simulation thread only.
+static clock::time_point s_slot {};
+static clock::time_point s_previous_begin {};
+static std::uint32_t s_streak = 0U;
+
+static governor_callback s_on_overrun;
+static governor_callback s_on_overload;
+static governor_callback s_on_recover;
+
+void configure_governor (const governor_config &config)
+{
+    std::lock_guard <std::mutex> lock {s_mutex};
+    s_config = config;
+}
+
+const governor_config governor ()
+{
+    std::lock_guard <std::mutex> lock {s_mutex};
+    return s_config;
+}
+
+void on_tick_overrun (governor_callback callback)
+{
+    s_on_overrun = std::move (callback);
+}
+
+void on_overload (governor_callback callback)
+{
+    s_on_overload = std::move (callback);
+}
+
+void on_recover (governor_callback callback)
+{
+    s_on_recover = std::move (callback);
+}
+
+const clock::time_point await_tick ()
+{
+    const governor_config config = governor ();
+    const clock::duration interval = tick_interval ();
+    const clock::time_point now = clock::now ();
+
+    std::int64_t behind = 0;
+    std::int64_t dropped = 0;
+    clock::duration lost = zero;
+    if (s_slot == clock::time_point {} || ! config.paced)
+        s_slot = now;
+    else if (now < s_slot)
+        std::this_thread::sleep_until (s_slot);
+    else
+    {
+        behind = (now - s_slot) / interval;
+        switch (config.policy)
+        {
+            case overrun_policy::catch_up:
+                dropped = std::max <std::int64_t> (behind - config.max_catch_up, 0);
+                break;
+            case overrun_policy::dilate:
+                lost = now - s_slot;
+                s_slot = now;
+                break;
+            case overrun_policy::skip:
+                dropped = behind;
+                break;
+        }
+        s_slot += dropped * interval;
+        lost += dropped * interval;
+    }
+
+    std::lock_guard <std::mutex> lock {s_mutex};
+    s_stats.behind = static_cast <std::uint32_t> (behind);
+    s_stats.skipped += static_cast <std::uint64_t> (dropped);
+    s_stats.lost += lost;
+    return s_slot;
+}
+
+void end_tick (const clock::time_point begin, const clock::duration took)
+{
+    const clock::duration interval = tick_interval ();
+    s_slot += interval;
+
+    tick_stats stats;
+    bool over = false;
+    bool overloaded = false;
+    bool recovered = false;
+    {
+        std::lock_guard <std::mutex> lock {s_mutex};
+        tick_stats &s = s_stats;
+        over = (std::chrono::duration <float> {took} > s_config.budget * std::chrono::duration <float> {interval});
+
+        ++s.ticks;
+        s.last = took;
+        s.mean = (s.ticks == 1U) ? took
+            : std::chrono::duration_cast <duration> (s.mean + (took - s.mean) * average_weight);
+        s.load = std::chrono::duration <float> {s.mean} / interval;
+        if (s_previous_begin != clock::time_point {} && begin > s_previous_begin)
+        {
+            const float scale = std::chrono::duration <float> {interval} / (begin - s_previous_begin);
+            s.time_scale += (scale - s.time_scale) * average_weight;
+        }
+        s_previous_begin = begin;
+
+        // Counts ticks over budget while healthy, and within it while not.
+        if (over)
+            ++s.over_budget;
+        s_streak = (over != s.overloaded) ? s_streak + 1U : 0U;
+        if (s_streak >= s_config.overload_after)
+        {
+            s.overloaded = ! s.overloaded;
+            overloaded = s.overloaded;
+            recovered = ! s.overloaded;
+            s_streak = 0U;
+        }
+        stats = s;
+    }
+
+    if (over && s_on_overrun)
+        s_on_overrun (stats);
+    if (overloaded && s_on_overload)
+        s_on_overload (stats);
+    if (recovered && s_on_recover)
+        s_on_recover (stats);
+}
+
+const tick_stats tick_statistics ()
+{
+    std::lock_guard <std::mutex> lock {s_mutex};
+    return s_stats;
+}
+
+} // namespace runtime
+} // namespace fost
@@ -0,0 +1,128 @@
+#include <core/trace_export.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <core/cpu_profiler.hpp>
+#include <core/perf_counters.hpp>
+#include <core/runtime.hpp>
+
+namespace fost
+{
+
+namespace // anonymous
+{
+
+struct thread_track
+{
+    std::uint32_t tid;
+    std::string name;
+    std::vector <zone_record> zones;
+};
+
+static void write_json_string (std::ostream &os, const char *str)
+{
+    os << '"';
+    for (; *str; ++str)
+    {
+        const char c = *str;
+        if (c == '"' || c == '\\')
+            os << '\\' << c;
+        else if (static_cast <unsigned char> (c) < 0x20)
+            os << ' ';
+        else
+            os << c;
+    }
+    os << '"';
+}
+
+// Trace event timestamps are microseconds, fractions are allowed.
+static double to_us (const clock::rep ticks)
+{
+    return std::chrono::duration <double, std::micro> (clock::duration {ticks}).count ();
+}
+
+} // namespace anonymous
+
+void export_chrome_trace (std::ostream &os)
+{
+    // Snapshot first, so no profiler registry lock is held during formatting.
+    std::vector <thread_track> tracks;
+    cpu_profiler::for_each ([&tracks] (const cpu_profiler &profiler)
+    {
+        thread_track track {profiler.thread_id (), profiler.thread_name (), {}};
+        std::uint64_t cursor = 0U;
+        profiler.collect (cursor, track.zones);
+        tracks.push_back (std::move (track));
+    });
+
+    clock::rep origin = std::numeric_limits <clock::rep>::max ();
+    for (const auto &track : tracks)
+        for (const auto &zone : track.zones)
+            origin = std::min (origin, zone.begin);
+
+    const auto flags = os.flags ();
+    const auto precision = os.precision ();
+    os.setf (std::ios::fixed);
+    os.precision (3);
+
+    os << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    os << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"Blockytry\"}}";
+
+    for (const auto &track : tracks)
+    {
+        os << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << track.tid
+           << ",\"args\":{\"name\":";
+        write_json_string (os, track.name.c_str ());
+        os << "}}";
+        os << ",\n{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":1,\"tid\":" << track.tid
+           << ",\"args\":{\"sort_index\":" << track.tid << "}}";
+
+        for (const auto &zone : track.zones)
+        {
+            os << ",\n{\"name\":";
+            write_json_string (os, zone.name);
+            os << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << track.tid
+               << ",\"ts\":" << to_us (zone.begin - origin)
+               << ",\"dur\":" << to_us (zone.end - zone.begin);
+            if (zone.has_counters || zone.allocations)
+            {
+                os << ",\"args\":{\"allocations\":" << zone.allocations
+                   << ",\"allocated_bytes\":" << zone.allocated_bytes;
+                if (zone.has_counters)
+                {
+                    os << ",\"cycles\":" << zone.counters[perf::cycles]
+                       << ",\"instructions\":" << zone.counters[perf::instructions]
+                       << ",\"llc_misses\":" << zone.counters[perf::cache_misses]
+                       << ",\"branch_misses\":" << zone.counters[perf::branch_misses]
+                       << ",\"ipc\":" << perf::ipc (zone.counters);
+                }
+                os << '}';
+            }
+            os << '}';
+        }
+    }
+
+    os << "\n]}\n";
+
+    os.flags (flags);
+    os.precision (precision);
+}
+
+const bool export_chrome_trace (const std::string &path)
+{
+    std::ofstream f {path, std::ios::out | std::ios::trunc};
+    if (! f.good ())
+        return false;
+
+    export_chrome_trace (f);
+    return f.good ();
+}
+
+} // namespace fost
@@ -1,17 +1,24 @@
 #include <version.hpp>
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <cassert>
+#include <cctype>
 #include <chrono>
+#include <csignal>
 #include <cstddef>
+#include <cstdint>
+#include <cstdlib>
 #include <fstream>
+#include <functional>
 #include <initializer_list>
 #include <iostream>
-#include <list>
+#include <mutex>
 #include <sstream>
+#include <string>
 #include <string_view>
 #include <thread>
-#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -28,8 +35,25 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtx/string_cast.hpp>
 
+#include <core/alloc_tracker.hpp>
+#include <core/bindings.hpp>
+#include <core/capture.hpp>
+#include <core/coroutine.hpp>
+#include <core/input.hpp>
 #include <core/runtime.hpp>
+#include <core/sampler.hpp>
+#include <core/spsc_queue.hpp>
+#include <core/task_graph.hpp>
+#include <core/tick_governor.hpp>
 #include <core/cpu_profiler.hpp>
+#include <core/gpu_profiler.hpp>
+#include <core/jobs.hpp>
+#include <core/perf_counters.hpp>
+#include <core/profiler_panel.hpp>
+#include <core/profiler_stream.hpp>
+#include <core/quality.hpp>
+#include <core/trace_export.hpp>
+#include <core/triple_buffer.hpp>
 
 // -=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
 // DEBUG macros
@@ -196,115 +220,130 @@ static void framebuffer_size_callback (GLFWwindow *window, int width, int height
 // static void character_callback (GLFWwindow *window, unsigned int codepoint);
 static void key_callback (GLFWwindow *window, int key, int scancode, int action, int mods);
 static void mouse_callback (GLFWwindow *window, double xpos, double ypos);
+static void focus_callback (GLFWwindow *window, int focused);
 
 // -=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
 // INPUT declarations
 // -=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
 
-class key_event
+// Key input.
+static constexpr std::size_t MAX_NUM_MBUTTONS = 16;
+// Set when running without a window, see run_headless.
+static bool g_headless = false;
+
+// Actions the simulation reads keys for, with their default keys. g_bindings
+// holds what they are bound to now; read and rebind it only before the
+// simulation starts or from the simulation thread.
+static constexpr fost::input::action_table <11> DEFAULT_BINDINGS {{
+    {"toggle hud",        GLFW_KEY_F1},
+    {"toggle debug hud",  GLFW_KEY_F3},
+    {"export trace",      GLFW_KEY_F12},
+    {"debug hold",        GLFW_KEY_H},
+    {"follow origin",     GLFW_KEY_T},
+    {"move forward",      GLFW_KEY_W},
+    {"move backward",     GLFW_KEY_S},
+    {"move left",         GLFW_KEY_A},
+    {"move right",        GLFW_KEY_D},
+    {"move up",           GLFW_KEY_PAGE_UP},
+    {"move down",         GLFW_KEY_PAGE_DOWN},
+}};
+static_assert (fost::input::unique_keys (DEFAULT_BINDINGS));
+
+static fost::input::bindings g_bindings {DEFAULT_BINDINGS};
+
+// Index of an action in g_bindings, checked at compile time.
+consteval std::size_t act (const char *name)
 {
-public:
-    key_event ()
-        : _pressed {fost::clock::now ()}
-        , _released {_pressed}
-    {}
-
-    ~key_event () = default;
-
-    inline const fost::clock::time_point & pressed() const
-    {
-        return _pressed;
-    }
-
-    inline const fost::clock::time_point & released() const
-    {
-        return _released;
-    }
-
-    inline const bool is_complete () const
-    {
-        return (_released != _pressed);
-    }
-
-    template <class _Unit = std::chrono::milliseconds>
-    inline const auto time_elapsed () const
-    {
-        return std::chrono::duration_cast <_Unit> (fost::clock::now () - _pressed);
-    }
-
-    inline const auto ticks_elapsed () const
-    {
-        return (time_elapsed () / fost::runtime::mspt);
-    }
-
-    template <class _Unit = std::chrono::milliseconds>
-    inline const auto time_held () const
-    {
-        assert (is_complete ());
-        return std::chrono::duration_cast <_Unit> (_released - _pressed);
-    }
-
-    inline const auto ticks_held () const
-    {
-        assert (is_complete ());
-        return (time_held () / fost::runtime::mspt);
-    }
-
-private:
-    // TODO: Friend input system class/function, not this global one.
-    friend void key_callback (GLFWwindow*, int, int, int, int);
+    return fost::input::action (DEFAULT_BINDINGS, name);
+}
 
-    fost::clock::time_point _pressed;
-    fost::clock::time_point _released;
+// Key the action is bound to now.
+inline const int bound (const std::size_t action)
+{
+    return g_bindings.key (action);
+}
 
-    inline void complete ()
-    {
-        assert (_released == _pressed);
-        _released = fost::clock::now ();
-    }
-};
+// Rebinds from "<action>=<key>", the key a GLFW key code or one character.
+static const bool bind_from_argument (const std::string_view binding);
 
-// Key input.
-static constexpr std::size_t MAX_NUM_KEYS = 256;
-static constexpr std::size_t MAX_NUM_MBUTTONS = 16;
-static std::list <key_event> g_keys[MAX_NUM_KEYS] = {};
-static std::unordered_set <int> g_completed_events = {};
+// Scancode of every GLFW key, -1 for keys the keyboard does not have. Asking
+// GLFW takes a trip into the platform layer, so the table is built once and
+// again whenever the window regains focus, in case the layout changed
+// meanwhile. Written by the window thread, read by the simulation.
+static std::array <std::atomic <int>, GLFW_KEY_LAST + 1> g_scancodes {};
 
+static void build_scancode_table ();
 inline const int resolve_scancode (const int key, int scancode);
-const std::list <key_event> & get_events (const int key, int scancode = -1);
-const std::list <key_event> get_complete (const int key, int scancode = -1);
-const int key_down (int key, int scancode = -1);
-const int key_up (int key, int scancode = -1);
-const long key_held (int key, int scancode = -1);
+inline const fost::input::key_ring & get_events (const int key, int scancode = -1);
+inline const fost::input::key_ring get_complete (const int key, int scancode = -1);
+inline const int key_down (int key, int scancode = -1);
+inline const int key_up (int key, int scancode = -1);
+inline const long key_held (int key, int scancode = -1);
+inline const bool key_pressed (int key, int scancode = -1);
 void prune_events ();
 
 // Mouse input.
+struct cursor_motion
+{
+    double x;
+    double y;
+};
+
 static GLboolean g_cursor_is_first_move = GL_TRUE;
 static GLfloat g_cursor_last_x = 0.0f;
 static GLfloat g_cursor_last_y = 0.0f;
-static GLfloat g_cursor_movement_x = 0.0f;
-static GLfloat g_cursor_movement_y = 0.0f;
-
-void cycle_mouse_to_be_renamed ()
+// Cursor movement summed since start, as the window thread polled it and as
+// the simulation has consumed it so far. Readers keep the total they last
+// saw and take the difference.
+static cursor_motion g_cursor_polled = {0.0, 0.0};
+static cursor_motion g_cursor_total = {0.0, 0.0};
+// Movement polled but not queued yet, sent once per frame.
+static cursor_motion g_cursor_pending = {0.0, 0.0};
+
+// Simulation thread only.
+const cursor_motion cursor_total ()
 {
-    g_cursor_movement_x = 0.0f;
-    g_cursor_movement_y = 0.0f;
+    return g_cursor_total;
 }
 
-GLfloat maxis_horizontal ()
-{
-    return g_cursor_movement_x;
-}
-GLfloat maxis_vertical ()
+// Raw events go from the window thread, where GLFW calls back, to the
+// simulation thread, which applies them all at the start of a tick.
+struct raw_input
 {
-    return g_cursor_movement_y;
-}
+    enum class kind : std::uint8_t
+    {
+        key_press = 0,
+        key_release,
+        cursor,
+    };
+
+    kind type;
+    int scancode;
+    cursor_motion motion;
+    fost::clock::time_point time;
+};
+
+// 1024 events are far more than a person types in a tick, and cursor
+// movement takes at most one per frame.
+static fost::spsc_queue <raw_input, 1024U> g_raw_input;
+// Window thread only. Key events wait here, in order, while the queue is full.
+// Releases that do not fit either are kept as bits, so no key is left held.
+static std::array <raw_input, 256U> g_input_backlog;
+static std::size_t g_input_backlog_head = 0U;
+static std::size_t g_input_backlog_size = 0U;
+static fost::input::key_mask g_input_lost_releases {};
+static bool g_input_warned = false;
+
+static void queue_input (const raw_input &event);
+static void flush_input ();
+static void consume_input ();
 
 // Configurations.
 static GLboolean g_wireframe = GL_FALSE;
 static GLboolean g_vsync = GL_FALSE;
-static GLboolean g_draw_hud = GL_TRUE;
-static GLboolean g_draw_debug_hud = GL_TRUE; // TODO: false default.
+// Toggled by ticks, read by the render thread.
+static std::atomic <bool> g_draw_hud = true;
+static std::atomic <bool> g_draw_debug_hud = true; // TODO: false default.
 
 // -=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
 // CAMERA | EYEPOINT | LENS declarations
@@ -328,7 +367,6 @@ public:
         , _far {100.0f}
     {}
 
-    void cycle (const std::chrono::duration<float> dt);
     void tick (const std::chrono::duration<float> dt);
 
     inline glm::mat4 see () const
@@ -375,6 +413,17 @@ public:
         return *_target;
     }
 
+    inline const bool is_locked_on () const
+    {
+        return (_target != nullptr);
+    }
+
+    // Cursor total the current yaw and pitch include.
+    inline const cursor_motion & get_cursor () const
+    {
+        return _cursor;
+    }
+
     inline const GLfloat get_yaw ()
     {
         return _yaw;
@@ -414,14 +463,14 @@ private:
     GLfloat _pitch;
     GLfloat _sensitivity_x;
     GLfloat _sensitivity_y;
+    cursor_motion _cursor = {0.0, 0.0};
+
+    // Applies the cursor movement since the last tick to yaw and pitch.
+    void turn (const cursor_motion &total);
 public: // TODO: should not be here..
     GLfloat _FOV = 45.0f;
     GLfloat _near = 0.1f;
     GLfloat _far = 100.0f;
-public: // TODO: should not exist..
-    static std::chrono::duration<float> elapsed;
-    static glm::vec3 prev_pos;
-    static glm::vec3 prev_dir;
 };
 
 // -=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
@@ -429,6 +478,47 @@ public: // TODO: should not exist..
 // -=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
 static auto g_lens = eyepoint {};
 static auto g_projection = glm::mat4 {1.0f};
+static int g_framebuffer_width = 1;
+static int g_framebuffer_height = 1;
+// Frames between ImGui rebuilds, the ones between redraw the last one.
+static std::uint32_t g_imgui_interval = 1U;
+
+// What the render thread needs of the simulation, copied out after each tick.
+struct sim_snapshot
+{
+    // When the tick was due and the tick interval at the time; interpolation
+    // runs one interval from there.
+    fost::clock::time_point time;
+    fost::clock::duration interval;
+    std::uint64_t tick;
+    glm::vec3 position;
+    glm::vec3 direction;
+    GLfloat yaw;
+    GLfloat pitch;
+    GLfloat sensitivity_x;
+    GLfloat sensitivity_y;
+    cursor_motion cursor;
+    bool locked_on;
+    // The same of the tick right before. Renders blend between these and the
+    // above, as the snapshots they receive may be several ticks apart.
+    glm::vec3 previous_position;
+    glm::vec3 previous_direction;
+    bool previous_locked_on;
+};
+
+static fost::triple_buffer <sim_snapshot> g_snapshots;
+static std::atomic <bool> g_simulating = false;
+
+// Tick timings are taken on the simulation thread and recorded by the render
+// thread, which owns the capture, stream and panel.
+struct tick_record
+{
+    fost::clock::time_point begin;
+    fost::clock::duration duration;
+};
+
+static std::mutex g_tick_records_mutex;
+static std::vector <tick_record> g_tick_records;
 
 // -=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
 // CALLBACK definitions
@@ -443,17 +533,31 @@ static void glfw_error_callback (int error, const char *desc)
 //     std::cout << "Window size: " << width << "x" << height << '\n';
 // }
 
-static void framebuffer_size_callback (GLFWwindow *window,
-                                       int width, int height)
+// Render thread only, like the far plane it reads.
+static void update_projection (const int width, const int height)
 {
-    glViewport (0, 0, width, height);
+    g_framebuffer_width = std::max (width, 1);
+    g_framebuffer_height = std::max (height, 1);
     g_projection = glm::perspective (glm::radians (g_lens._FOV),
-                                     (float) width / (float) height,
+                                     (float) g_framebuffer_width / (float) g_framebuffer_height,
                                      g_lens._near,
                                      g_lens._far);
+}
+
+static void framebuffer_size_callback (GLFWwindow *window,
+                                       int width, int height)
+{
+    glViewport (0, 0, width, height);
+    update_projection (width, height);
     // std::cout << "Framebuffer size: " << width << "x" << height << '\n';
 }
 
+static void focus_callback (GLFWwindow *window, int focused)
+{
+    if (focused)
+        build_scancode_table ();
+}
+
 // static void character_callback (GLFWwindow *window, unsigned int codepoint)
 // {
 //     std::cerr << codepoint; // cerr is automatically flushed.
@@ -501,16 +605,14 @@ static void key_callback (GLFWwindow *window,
             default:
                 break;
         }
-        g_keys[scancode].emplace_back ();
+        queue_input ({raw_input::kind::key_press, scancode, {}, fost::clock::now ()});
         // std::cout << "[Callback] Key " << scancode << " pressed now\n";
     }
     else if (action == GLFW_RELEASE)
     {
-        assert (g_keys[scancode].size () != 0);
-        g_keys[scancode].back ().complete ();
-        g_completed_events.insert (scancode);
-        // const auto dd = g_keys[scancode].back ().time_held <std::chrono::milliseconds> ();
-        // const auto ticks = g_keys[scancode].back ().ticks_held ();
+        queue_input ({raw_input::kind::key_release, scancode, {}, fost::clock::now ()});
+        // const auto dd = fost::input::events (scancode).back ().time_held <std::chrono::milliseconds> ();
+        // const auto ticks = fost::input::events (scancode).back ().ticks_held ();
         // std::cout << "[Callback] Key " << scancode << " released after " << dd.count () << " ms or " << ticks << " ticks.\n";
     }
 }
@@ -524,8 +626,11 @@ static void mouse_callback (GLFWwindow *window, double xpos, double ypos)
         g_cursor_is_first_move = GL_FALSE;
     }
 
-    g_cursor_movement_x = xpos - g_cursor_last_x;
-    g_cursor_movement_y = g_cursor_last_y - ypos;
+    const cursor_motion moved = {xpos - g_cursor_last_x, g_cursor_last_y - ypos};
+    g_cursor_polled.x += moved.x;
+    g_cursor_polled.y += moved.y;
+    g_cursor_pending.x += moved.x;
+    g_cursor_pending.y += moved.y;
 
     g_cursor_last_x = xpos;
     g_cursor_last_y = ypos;
@@ -535,134 +640,237 @@ static void mouse_callback (GLFWwindow *window, double xpos, double ypos)
 // -=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
 // INPUT definitions
 // -=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
-inline const int resolve_scancode (const int key, int scancode)
+static void queue_input (const raw_input &event)
 {
-    if (key > 0)
+    // Events already waiting go first.
+    if (g_input_backlog_size == 0U && ! g_input_lost_releases.any () && g_raw_input.try_push (event))
+        return;
+
+    if (g_input_backlog_size < g_input_backlog.size ())
+    {
+        g_input_backlog[(g_input_backlog_head + g_input_backlog_size++) % g_input_backlog.size ()] = event;
+        return;
+    }
+
+    if (event.type == raw_input::kind::key_release && event.scancode >= 0
+        && static_cast <std::size_t> (event.scancode) < fost::input::max_keys)
+    {
+        g_input_lost_releases.set (event.scancode);
+        return;
+    }
+
+    if (! g_input_warned)
+    {
+        std::cerr << "warn: input queue full, dropping key presses until the simulation catches up\n";
+        g_input_warned = true;
+    }
+}
+
+// Sends what queue_input held back and the cursor movement of the frame.
+// Whatever does not fit stays pending, nothing is lost.
+static void flush_input ()
+{
+    while (g_input_backlog_size != 0U && g_raw_input.try_push (g_input_backlog[g_input_backlog_head]))
+    {
+        g_input_backlog_head = (g_input_backlog_head + 1U) % g_input_backlog.size ();
+        --g_input_backlog_size;
+    }
+
+    if (g_input_backlog_size == 0U && g_input_lost_releases.any ())
+    {
+        const fost::clock::time_point now = fost::clock::now ();
+        for (int scancode = 0; scancode < static_cast <int> (fost::input::max_keys); ++scancode)
+        {
+            if (! g_input_lost_releases.test (scancode))
+                continue;
+            if (! g_raw_input.try_push ({raw_input::kind::key_release, scancode, {}, now}))
+                break;
+            g_input_lost_releases.reset (scancode);
+        }
+    }
+    if (g_input_backlog_size == 0U && ! g_input_lost_releases.any ())
+        g_input_warned = false;
+
+    if (g_cursor_pending.x == 0.0 && g_cursor_pending.y == 0.0)
+        return;
+
+    if (g_raw_input.try_push ({raw_input::kind::cursor, 0, g_cursor_pending, fost::clock::now ()}))
+        g_cursor_pending = {0.0, 0.0};
+}
+
+static void consume_input ()
+{
+    raw_input event;
+    while (g_raw_input.try_pop (event))
+    {
+        switch (event.type)
+        {
+            case raw_input::kind::key_press:
+                fost::input::press (event.scancode, event.time);
+                break;
+            case raw_input::kind::key_release:
+                fost::input::release (event.scancode, event.time);
+                break;
+            case raw_input::kind::cursor:
+                g_cursor_total.x += event.motion.x;
+                g_cursor_total.y += event.motion.y;
+                break;
+        }
+    }
+}
+
+static void build_scancode_table ()
+{
+    // Without a window no key is ever pressed, and GLFW is not there to ask.
+    // Every key stays at scancode 0.
+    if (g_headless)
+        return;
+
+    for (int key = 0; key <= GLFW_KEY_LAST; ++key)
     {
-        scancode = glfwGetKeyScancode (key);
+        const int scancode = (key >= GLFW_KEY_SPACE) ? glfwGetKeyScancode (key) : -1;
+        g_scancodes[key].store (scancode, std::memory_order_relaxed);
     }
-    assert (scancode > 0);
+}
+
+inline const int resolve_scancode (const int key, int scancode)
+{
+    // Unbound actions, and keys GLFW does not know, resolve to -1 and never
+    // fire.
+    if (key > 0)
+        return (key <= GLFW_KEY_LAST) ? g_scancodes[key].load (std::memory_order_relaxed) : -1;
     return scancode;
 }
 
-const std::list <key_event> & get_events (const int key, int scancode)
+static const bool bind_from_argument (const std::string_view binding)
 {
-    scancode = resolve_scancode (key, scancode);
-    return g_keys[scancode];
+    const std::size_t split = binding.rfind ('=');
+    if (split == std::string_view::npos || split + 1U == binding.size ())
+        return false;
+
+    const std::string_view name = binding.substr (0U, split);
+    const std::string key_name {binding.substr (split + 1U)};
+    int key = fost::input::unbound;
+    if (key_name.size () == 1U)
+        key = std::toupper (static_cast <unsigned char> (key_name[0]));
+    else if (key_name != "none")
+        key = static_cast <int> (std::strtol (key_name.c_str (), nullptr, 10));
+
+    for (std::size_t action = 0U; action < g_bindings.size (); ++action)
+    {
+        if (g_bindings.name (action) != name)
+            continue;
+
+        if (! g_bindings.rebind (action, key))
+            std::cerr << "warn: key " << key_name << " is bound twice, leaving both actions unbound\n";
+        return true;
+    }
+    return false;
 }
 
-const std::list <key_event> get_complete (const int key, int scancode)
+inline const fost::input::key_ring & get_events (const int key, int scancode)
 {
-    scancode = resolve_scancode (key, scancode);
-    auto complete_events = g_keys[scancode];
-    if (complete_events.size () > 0 && (! complete_events.back ().is_complete ()))
-        complete_events.pop_back ();
-    return complete_events;
+    return fost::input::events (resolve_scancode (key, scancode));
 }
 
-const int key_down (const int key, int scancode)
+inline const fost::input::key_ring get_complete (const int key, int scancode)
 {
-    scancode = resolve_scancode (key, scancode);
-    auto downs_in_cur_tick = g_keys[scancode].size ();
+    return fost::input::complete_events (resolve_scancode (key, scancode));
+}
 
-    if (downs_in_cur_tick > 0 && g_keys[scancode].front ().ticks_elapsed () > 0L)
-        --downs_in_cur_tick;
+inline const int key_down (const int key, int scancode)
+{
+    return fost::input::key_down (resolve_scancode (key, scancode));
+}
 
-    return static_cast <int> (downs_in_cur_tick);
+inline const int key_up (const int key, int scancode)
+{
+    return fost::input::key_up (resolve_scancode (key, scancode));
 }
 
-const int key_up (const int key, int scancode)
+inline const long key_held (const int key, int scancode)
 {
-    scancode = resolve_scancode (key, scancode);
-    auto count = g_keys[scancode].size ();
-    if (count > 0 && (! g_keys[scancode].back ().is_complete ()))
-        --count;
-    return static_cast <int> (count);
+    return fost::input::key_held (resolve_scancode (key, scancode));
 }
 
-const long key_held (const int key, int scancode)
+inline const bool key_pressed (const int key, int scancode)
 {
-    scancode = resolve_scancode (key, scancode);
-    return (g_keys[scancode].size () == 0 || g_keys[scancode].back ().is_complete ())
-        ? 0L
-        : g_keys[scancode].back ().ticks_elapsed ();
+    return fost::input::is_pressed (resolve_scancode (key, scancode));
 }
 
 void prune_events ()
 {
-    for (int scancode : g_completed_events)
-    {
-        assert (g_keys[scancode].size () != 0);
-        auto begin = g_keys[scancode].cbegin ();
-        auto end = g_keys[scancode].cend ();
-        if (! g_keys[scancode].back ().is_complete ())
-            --end;
-        if (begin != end)
-            g_keys[scancode].erase (begin, end);
-    }
-    g_completed_events.clear ();
+    fost::input::prune ();
 }
 
 // -=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
 // CAMERA | EYEPOINT | LENS definitions
 // -=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
-std::chrono::duration<float> eyepoint::elapsed {};
-glm::vec3 eyepoint::prev_pos {};
-glm::vec3 eyepoint::prev_dir {};
-void eyepoint::cycle (const std::chrono::duration<float> dt)
+static void clamp_angles (GLfloat &yaw, GLfloat &pitch)
+{
+    if (pitch > 89.9f)
+        pitch = 89.9f;
+    if (pitch < -89.9f)
+        pitch = -89.9f;
+
+    if (yaw > 180.0f)
+        yaw -= 360.0f;
+    if (yaw < -180.0f)
+        yaw += 360.0f;
+}
+
+static glm::vec3 direction_of (const GLfloat yaw, const GLfloat pitch)
+{
+    const auto pitch_in_radians = glm::radians(pitch);
+    const auto yaw_in_radians = glm::radians(yaw);
+    const auto cos_of_pitch = glm::cos(pitch_in_radians);
+    return glm::normalize (glm::vec3 {glm::cos(yaw_in_radians) * cos_of_pitch,
+                                      glm::sin(pitch_in_radians),
+                                      glm::sin(yaw_in_radians) * cos_of_pitch});
+}
+
+static glm::vec3 up_of (const glm::vec3 &direction)
+{
+    const glm::vec3 right_vec = glm::normalize (glm::cross (direction, world_up));
+    return glm::normalize (glm::cross (right_vec, direction));
+}
+
+// Free look as the render thread sees it: the angles of the latest tick plus
+// the cursor movement no tick has taken yet, so turning never waits a tick.
+static glm::vec3 look_direction (const sim_snapshot &s, const cursor_motion &cursor)
+{
+    GLfloat yaw = s.yaw + static_cast <GLfloat> (cursor.x - s.cursor.x) * s.sensitivity_x;
+    GLfloat pitch = s.pitch + static_cast <GLfloat> (cursor.y - s.cursor.y) * s.sensitivity_y;
+    clamp_angles (yaw, pitch);
+    return direction_of (yaw, pitch);
+}
+
+void eyepoint::turn (const cursor_motion &total)
 {
-    // elapsed += dt;
-    // if (elapsed >= 1s)
-    // {
-    //     elapsed = 0s;
-    //     // FOST_LOG_INFO ("Moved {} units in 1 second", glm::to_string (glm::abs (_position - prev_pos)));
-    //     // FOST_LOG_INFO ("Pos {}", glm::to_string (_position));
-    //     prev_pos = _position;
-    // }
-    // FOST_LOG_INFO ("Pos {}", glm::to_string (_position));
-
-    // TODO: Get mouse input already!
+    const cursor_motion moved = {total.x - _cursor.x, total.y - _cursor.y};
+    _cursor = total;
+
+    // Movement while locked on is dropped, not saved up for later.
     if (! _target)
     {
-        prev_dir = _direction;
-        // Get input from mouse for orientation.
-        _yaw += maxis_horizontal () * _sensitivity_x;
-        _pitch += maxis_vertical () * _sensitivity_y;
-
-        if (_pitch > 89.9f)
-            _pitch = 89.9f;
-        if (_pitch < -89.9f)
-            _pitch = -89.9f;
-
-        if (_yaw > 180.0f)
-            _yaw -= 360.0f;
-        if (_yaw < -180.0f)
-            _yaw += 360.0f;
-
-        const auto pitch_in_radians = glm::radians(_pitch);
-        const auto yaw_in_radians = glm::radians(_yaw);
-        const auto cos_of_pitch = glm::cos(pitch_in_radians);
-        _direction.x = glm::cos(yaw_in_radians) * cos_of_pitch;
-        _direction.y = glm::sin(pitch_in_radians);
-        _direction.z = glm::sin(yaw_in_radians) * cos_of_pitch;
-        _direction = glm::normalize(_direction);
-        // std::cout << "[Cycle] Position " << glm::to_string (_position) << '\n';
-        // std::cout << "[Cycle] Direction: " << glm::to_string (_direction) << '\n';
-        // std::cout << "[Cycle] Prev Direction: " << glm::to_string (prev_dir) << '\n';
+        _yaw += static_cast <GLfloat> (moved.x) * _sensitivity_x;
+        _pitch += static_cast <GLfloat> (moved.y) * _sensitivity_y;
+        clamp_angles (_yaw, _pitch);
+        _direction = direction_of (_yaw, _pitch);
     }
 }
 
 // TODO: restrict mouse movement when locked on. Require mouse_input for this.
 void eyepoint::tick (const std::chrono::duration<float> dt)
 {
-    prev_pos = _position;
+    turn (cursor_total ());
 
     // std::cout << "[tick] dt: " << (dt / 1s) << '\n';
 
     static constexpr GLfloat slow_walk = {0.1f};
     static constexpr GLfloat norm_walk = {1.0f};
 
-    if (key_down (GLFW_KEY_T))
+    if (key_down (bound (act ("follow origin"))))
     {
         if (_target)
         {
@@ -674,7 +882,6 @@ void eyepoint::tick (const std::chrono::duration<float> dt)
             static constexpr glm::vec3 target = {0.0f, 0.0f, 0.0f};
             lock_on (&target);
             _direction = glm::normalize (*_target - _position);
-            prev_dir = _direction; // in this case, prev is set after because whenever we have teleportations, we can't blend the vectors, it must be a complete jump.
             std::cout << "[Tick] Following origin.\n";
         }
     }
@@ -682,32 +889,32 @@ void eyepoint::tick (const std::chrono::duration<float> dt)
     const glm::vec3 right_vec = glm::normalize (glm::cross (_direction, world_up));
     _up = glm::normalize (glm::cross (right_vec, _direction));
 
-    if (key_held (GLFW_KEY_PAGE_UP))
+    if (key_held (bound (act ("move up"))))
     {
         // std::cout << "[Tick] Bigger step forward.\n";
         _position += world_up * norm_walk * (dt / 1s);
     }
-    if (key_held (GLFW_KEY_PAGE_DOWN))
+    if (key_held (bound (act ("move down"))))
     {
         // std::cout << "[Tick] Bigger step backward.\n";
         _position -= world_up * norm_walk * (dt / 1s);
     }
-    if (key_held (GLFW_KEY_W))
+    if (key_held (bound (act ("move forward"))))
     {
         // std::cout << "[Tick] Bigger step forward.\n";
         _position += _direction * norm_walk * (dt / 1s);
     }
-    if (key_held (GLFW_KEY_S))
+    if (key_held (bound (act ("move backward"))))
     {
         // std::cout << "[Tick] Bigger step backward.\n";
         _position -= _direction * norm_walk * (dt / 1s);
     }
-    if (key_held (GLFW_KEY_A))
+    if (key_held (bound (act ("move left"))))
     {
         // std::cout << "[Tick] Bigger step left.\n";
         _position -= right_vec * norm_walk * (dt / 1s);
     }
-    if (key_held (GLFW_KEY_D))
+    if (key_held (bound (act ("move right"))))
     {
         // std::cout << "[Tick] Bigger step right.\n";
         _position += right_vec * norm_walk * (dt / 1s);
@@ -718,7 +925,6 @@ void eyepoint::tick (const std::chrono::duration<float> dt)
     // insignificant to involve trigonometrics into this.
     if (_target)
     {
-        prev_dir = _direction;
         _direction = glm::normalize (*_target - _position);
         _pitch = glm::asin (_direction.y);
         _yaw = glm::degrees (glm::asin (_direction.z / glm::cos (_pitch)));
@@ -735,7 +941,6 @@ void eyepoint::tick (const std::chrono::duration<float> dt)
 
     // std::cout << "Position " << glm::to_string (_position) << '\n';
     // std::cout << "[Tick] Direction: " << glm::to_string (_direction) << '\n';
-    // std::cout << "[Tick] Prev Direction: " << glm::to_string (prev_dir) << '\n';
     // std::cout << "Pitch: " << _pitch << '\n';
     // std::cout << "Yaw: " << _yaw << '\n';
 }
@@ -749,6 +954,280 @@ void clean_glfw (GLFWwindow *window)
     glfwTerminate ();
 }
 
+// Writes a Chrome trace of the profiler buffers on a worker, so ticks do not
+// stall on formatting, and reports back on the simulation thread.
+static fost::task export_trace ()
+{
+    const auto stamp = std::chrono::duration_cast <std::chrono::seconds> (fost::runtime::get ()).count ();
+    const std::string trace_path = "blockytry_trace_" + std::to_string (stamp) + ".json";
+
+    co_await fost::runtime::on_worker ();
+    const bool saved = fost::export_chrome_trace (trace_path);
+
+    co_await fost::runtime::next_tick ();
+    if (saved)
+        std::cout << "Saved profiler trace to " << trace_path << '\n';
+    else
+        std::cerr << "Failed to save profiler trace to " << trace_path << '\n';
+}
+
+static void publish_snapshot (const std::uint64_t tick, const fost::clock::time_point time)
+{
+    static sim_snapshot last {};
+    sim_snapshot &s = g_snapshots.back ();
+    s.time = time;
+    s.interval = fost::runtime::tick_interval ();
+    s.tick = tick;
+    s.position = g_lens.get_position ();
+    s.direction = g_lens.get_direction ();
+    s.yaw = g_lens.get_yaw ();
+    s.pitch = g_lens.get_pitch ();
+    s.sensitivity_x = g_lens.get_sensitivity_x ();
+    s.sensitivity_y = g_lens.get_sensitivity_y ();
+    s.cursor = g_lens.get_cursor ();
+    s.locked_on = g_lens.is_locked_on ();
+    // Tick 0 has nothing before it.
+    const sim_snapshot &before = (tick > 0U) ? last : s;
+    s.previous_position = before.position;
+    s.previous_direction = before.direction;
+    s.previous_locked_on = before.locked_on;
+    last = s;
+    g_snapshots.publish ();
+}
+
+// Fixed step simulation on its own thread, so a slow frame does not hold
+// ticks back and a long tick does not drop frames. Renders see the world
+// only through g_snapshots. The tick governor decides when ticks run. Stops
+// after tick_limit ticks unless it is 0.
+static void simulate (fost::task_graph &tick_graph, const std::uint64_t tick_limit)
+{
+    fost::set_thread_name ("Simulation thread");
+    fost::sampler::register_thread ();
+
+    // This thread is worker 0, the render thread keeps a core to itself.
+    const unsigned int cores = std::thread::hardware_concurrency ();
+    fost::jobs::init ((cores > 1U) ? (cores - 1U) : 1U);
+    std::cout << "Job system running " << fost::jobs::worker_count () << " workers\n";
+
+    std::uint64_t tick = 0U;
+    while (g_simulating.load (std::memory_order_acquire))
+    {
+        const fost::clock::time_point due = fost::runtime::await_tick ();
+        {
+            FOST_PROFILE_ZONE_COUNTERS ("tick");
+            const fost::clock::time_point tick_begin = fost::clock::now ();
+            consume_input ();
+            fost::input::sample ();
+            tick_graph.run ();
+            {
+                FOST_PROFILE_ZONE ("coroutines");
+                fost::runtime::resume_coroutines ();
+            }
+            publish_snapshot (++tick, due);
+
+            const fost::clock::duration tick_duration = fost::clock::now () - tick_begin;
+            fost::runtime::end_tick (tick_begin, tick_duration);
+            std::lock_guard <std::mutex> lock {g_tick_records_mutex};
+            g_tick_records.push_back ({tick_begin, tick_duration});
+        }
+
+        if (tick == tick_limit)
+            g_simulating.store (false, std::memory_order_release);
+    }
+
+    fost::runtime::wait_worker_coroutines ();
+    fost::jobs::shutdown ();
+    fost::runtime::destroy_coroutines ();
+}
+
+static const bool build_tick_graph (fost::task_graph &graph)
+{
+    // Systems run every tick. Independent ones run in parallel on the job
+    // workers, see task_graph.
+    enum tick_resource : std::size_t
+    {
+        res_input = 0,  // fost::input.
+        res_mouse,      // g_cursor_total.
+        res_hud,        // g_draw_hud and g_draw_debug_hud.
+        res_lens,       // g_lens.
+    };
+
+    graph.add ("hud keys", {res_input}, {res_hud}, [] ()
+    {
+        if (key_pressed (bound (act ("toggle hud"))))
+        {
+            g_draw_hud = ! g_draw_hud;
+            std::cout << "Draw hud " << static_cast <int> (g_draw_hud.load ()) << '\n';
+        }
+        if (g_draw_hud && key_pressed (bound (act ("toggle debug hud"))))
+        {
+            g_draw_debug_hud = ! g_draw_debug_hud;
+            std::cout << "Draw debug hud " << static_cast <int> (g_draw_debug_hud.load ()) << '\n';
+        }
+    });
+    graph.add ("trace export", {res_input}, {}, [] ()
+    {
+        if (key_pressed (bound (act ("export trace"))))
+            export_trace ();
+    });
+    graph.add ("debug keys", {res_input}, {}, [] ()
+    {
+        if (const auto amount = key_held (bound (act ("debug hold"))))
+        {
+            std::cout << "Held H for " << amount << '\n';
+        }
+    });
+    graph.add ("lens tick", {res_input, res_mouse}, {res_lens}, [] ()
+    {
+        g_lens.tick (fost::runtime::tick_interval ());
+    });
+    graph.add ("prune events", {}, {res_input}, [] ()
+    {
+        prune_events ();
+    });
+    if (! graph.compile ())
+    {
+        std::cerr << "Failed to build the tick graph.\n";
+        return false;
+    }
+    graph.describe (std::cout);
+    return true;
+}
+
+static void start_profiling (const char *capture_path, const char *sample_path, const std::string &stream_path)
+{
+    if (capture_path)
+    {
+        if (fost::capture::start (capture_path))
+            std::cout << "Capturing frames to " << capture_path << '\n';
+        else
+            std::cerr << "Failed to open capture file " << capture_path << '\n';
+    }
+
+    // Started before any other thread, so they can register with it.
+    if (sample_path)
+    {
+        if (fost::sampler::start ())
+            std::cout << "Sampling call stacks to " << sample_path << '\n';
+        else
+            std::cerr << "Failed to start the sampling profiler\n";
+    }
+
+    // Live profiler feed for tools/framegrapher. Idle until a viewer connects.
+    if (! stream_path.empty ())
+    {
+        if (fost::stream::start (stream_path))
+            std::cout << "Profiler stream listening on " << stream_path << '\n';
+        else
+            std::cerr << "Failed to listen for profiler viewers on " << stream_path << '\n';
+    }
+}
+
+static void stop_profiling (const char *sample_path)
+{
+    fost::stream::stop ();
+    fost::capture::stop ();
+    if (fost::sampler::is_running ())
+    {
+        fost::sampler::stop ();
+        if (fost::sampler::write_folded (sample_path))
+            std::cout << "Wrote " << fost::sampler::samples () << " samples (" << fost::sampler::dropped ()
+                      << " dropped) to " << sample_path << '\n';
+        else
+            std::cerr << "Failed to write samples to " << sample_path << '\n';
+    }
+}
+
+// Hands the ticks finished since the last call to the profilers. Returns how
+// many there were.
+static const std::uint32_t record_ticks (std::vector <tick_record> &records)
+{
+    records.clear ();
+    {
+        std::lock_guard <std::mutex> lock {g_tick_records_mutex};
+        records.swap (g_tick_records);
+    }
+    for (const tick_record &r : records)
+    {
+        fost::capture::record_tick (r.begin, r.duration);
+        fost::stream::record_tick (r.begin, r.duration);
+        fost::profiler_panel::record_tick (r.duration);
+    }
+    return static_cast <std::uint32_t> (records.size ());
+}
+
+// Warns when ticks stop fitting their budget, before the simulation spirals.
+static void watch_tick_load ()
+{
+    fost::runtime::on_overload ([] (const fost::runtime::tick_stats &stats)
+    {
+        std::cerr << "warn: ticks over budget, averaging "
+                  << std::chrono::duration <double, std::milli> {stats.mean}.count () << " ms ("
+                  << static_cast <int> (stats.load * 100.0f) << "% of the tick interval)\n";
+    });
+    fost::runtime::on_recover ([] (const fost::runtime::tick_stats &stats)
+    {
+        std::cout << "Ticks back within budget after " << stats.skipped << " skipped in total\n";
+    });
+}
+
+static void stop_simulation (int)
+{
+    g_simulating.store (false, std::memory_order_relaxed);
+}
+
+// Runs the simulation with no window, GL or ImGui, for servers, soak tests
+// and benchmarks. There is no keyboard, so input systems see no keys.
+static int run_headless (const std::uint64_t tick_limit)
+{
+    fost::task_graph tick_graph;
+    if (! build_tick_graph (tick_graph))
+        return 1;
+
+    std::signal (SIGINT, stop_simulation);
+    std::signal (SIGTERM, stop_simulation);
+
+    std::cout << "Running headless, " << (fost::runtime::governor ().paced ? "in real time" : "as fast as possible");
+    if (tick_limit)
+        std::cout << ", for " << tick_limit << " ticks";
+    std::cout << '\n';
+
+    const fost::clock::time_point begin = fost::clock::now ();
+    g_simulating.store (true, std::memory_order_release);
+    std::thread simulation {simulate, std::ref (tick_graph), tick_limit};
+
+    // Stands in for the frame loop: feeds the profilers about once a tick.
+    std::vector <tick_record> records;
+    std::uint64_t ticks = 0U;
+    fost::clock::duration busy {0};
+    bool running = true;
+    while (running)
+    {
+        running = g_simulating.load (std::memory_order_acquire);
+        if (running)
+            std::this_thread::sleep_for (fost::runtime::tick_interval ());
+        else
+            simulation.join ();
+
+        ticks += record_ticks (records);
+        for (const tick_record &r : records)
+            busy += r.duration;
+        fost::capture::collect_zones ();
+        fost::stream::collect_zones ();
+        fost::sampler::collect ();
+    }
+
+    const std::chrono::duration <double> elapsed = fost::clock::now () - begin;
+    std::cout << "Ran " << ticks << " ticks in " << elapsed.count () << " s ("
+              << (ticks / elapsed.count ()) << " tps), "
+              << (ticks ? std::chrono::duration <double, std::milli> {busy}.count () / ticks : 0.0)
+              << " ms per tick\n";
+    const fost::runtime::tick_stats stats = fost::runtime::tick_statistics ();
+    std::cout << stats.over_budget << " ticks over budget, " << stats.skipped << " skipped, "
+              << std::chrono::duration <double> {stats.lost}.count () << " s not simulated\n";
+    return 0;
+}
+
 #define ENABLE_CRAPPY_BUILD 0
 
 #if ENABLE_CRAPPY_BUILD
@@ -762,9 +1241,88 @@ void threadfunc (const std::string &name)
 
 int main (int argc, char **argv)
 {
+    fost::set_thread_name ("Main thread");
     FOST_LOG_INFO ("Welcome to {} from spdlog!", "Blockytry");
     std::cout << "Blockytry " << BLOCKYTRY_VERSION_STRING << '\n';
 
+    // Command line.
+    const char *capture_path = nullptr;
+    const char *sample_path = nullptr;
+    bool headless = false;
+    fost::runtime::governor_config governor;
+    std::uint64_t tick_limit = 0U;
+#ifdef FOST_PROFILER
+    std::string stream_path = fost::stream::default_socket_path ();
+#else
+    std::string stream_path;
+#endif
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string_view arg {argv[i]};
+        if (arg == "--capture" && i + 1 < argc)
+            capture_path = argv[++i];
+        else if (arg == "--stream" && i + 1 < argc)
+            stream_path = argv[++i];
+        else if (arg == "--no-stream")
+            stream_path.clear ();
+        else if (arg == "--sample" && i + 1 < argc)
+            sample_path = argv[++i];
+        else if (arg == "--perf-counters")
+            fost::perf::set_enabled (true);
+        else if (arg == "--headless")
+            headless = true;
+        else if (arg == "--unpaced")
+            governor.paced = false;
+        else if (arg == "--overrun" && i + 1 < argc)
+        {
+            const std::string_view policy {argv[++i]};
+            if (policy == "catch-up")
+                governor.policy = fost::runtime::overrun_policy::catch_up;
+            else if (policy == "dilate")
+                governor.policy = fost::runtime::overrun_policy::dilate;
+            else if (policy == "skip")
+                governor.policy = fost::runtime::overrun_policy::skip;
+            else
+                std::cerr << "warn: unknown overrun policy " << policy << ", keeping catch-up\n";
+        }
+        else if (arg == "--ticks" && i + 1 < argc)
+            tick_limit = std::strtoull (argv[++i], nullptr, 10);
+        else if (arg == "--tps" && i + 1 < argc)
+            fost::runtime::set_tps (static_cast <std::uint16_t> (std::min (std::strtoul (argv[++i], nullptr, 10), 65535UL)));
+        else if (arg == "--target-fps" && i + 1 < argc)
+        {
+            const double target = std::strtod (argv[++i], nullptr);
+            if (target > 0.0)
+                fost::quality::set_target_frame_time (std::chrono::duration_cast <fost::clock::duration> (
+                    std::chrono::duration <double> {1.0 / target}));
+        }
+        else if (arg == "--frame-cap" && i + 1 < argc)
+            fost::runtime::set_frame_cap (std::strtof (argv[++i], nullptr));
+        else if (arg == "--bind" && i + 1 < argc)
+        {
+            if (! bind_from_argument (argv[++i]))
+                std::cerr << "warn: ignoring binding " << argv[i] << ", expected <action>=<key>\n";
+        }
+        else
+            std::cerr << "warn: ignoring unknown argument " << arg << '\n';
+    }
+    fost::runtime::configure_governor (governor);
+    watch_tick_load ();
+
+    if (headless)
+    {
+        g_headless = true;
+        start_profiling (capture_path, sample_path, stream_path);
+        const int status = run_headless (tick_limit);
+        stop_profiling (sample_path);
+        return status;
+    }
+
+    // Before anything that needs cleaning up, so a bad graph can just return.
+    fost::task_graph tick_graph;
+    if (! build_tick_graph (tick_graph))
+        return 1;
+
     // Set error callback.
     glfwSetErrorCallback (glfw_error_callback);
 
@@ -843,6 +1401,8 @@ int main (int argc, char **argv)
     // glfwSetCharCallback(window, character_callback);
     glfwSetKeyCallback (window, key_callback);
     glfwSetCursorPosCallback (window, mouse_callback);
+    glfwSetWindowFocusCallback (window, focus_callback);
+    build_scancode_table ();
 
     // Setup Dear ImGui context
     IMGUI_CHECKVERSION ();
@@ -860,6 +1420,10 @@ int main (int argc, char **argv)
     ImGui_ImplGlfw_InitForOpenGL (window, true);
     ImGui_ImplOpenGL3_Init ("#version 330");
 
+#ifdef FOST_PROFILER
+    fost::gpu::init ();
+#endif
+
     // Load Fonts
     // - If no fonts are loaded, dear imgui will use the default font. You can also load multiple fonts and use ImGui::PushFont()/PopFont() to select them.
     // - AddFontFromFileTTF() will return the ImFont* so you can store it if you need to select the font among multiple.
@@ -1012,84 +1576,99 @@ int main (int argc, char **argv)
     const GLfloat radius = 0.5f;
     GLfloat time = 0.0f;
 
-    g_projection = glm::perspective (glm::radians (g_lens._FOV),
-                                     (float) width / (float) height,
-                                     g_lens._near,
-                                     g_lens._far);
+    update_projection (width, height);
 
-    FOST_LOG_INFO ("Tickrate: {} mspt | {} tps", fost::runtime::mspt.count (), fost::runtime::tps);
+    // Quality the governor may give up to hold --target-fps, cheapest first.
+    fost::quality::add_knob ("imgui refresh", 4U, 3U, 0, [] (const std::uint32_t level)
+    {
+        g_imgui_interval = 4U - level;
+    });
+    fost::quality::add_knob ("render distance", 4U, 3U, 1, [] (const std::uint32_t level)
+    {
+        g_lens._far = 25.0f * static_cast <GLfloat> (level + 1U);
+        update_projection (g_framebuffer_width, g_framebuffer_height);
+    });
 
-    fost::runtime::duration accumulator {0s};
-    fost::runtime::time_point t {};
+    FOST_LOG_INFO ("Tickrate: {} mspt | {} tps", fost::runtime::mspt ().count (), fost::runtime::tps ());
 
     int frame_count = 0;
 
+    start_profiling (capture_path, sample_path, stream_path);
+
+    // The first snapshot comes from here, so the first frame has one to show.
+    publish_snapshot (0U, fost::clock::now ());
+    g_snapshots.update ();
+    sim_snapshot current = g_snapshots.front ();
+    std::vector <tick_record> frame_tick_records;
+    std::uint32_t imgui_frames = 0U;
+
+    g_simulating.store (true, std::memory_order_release);
+    std::thread simulation {simulate, std::ref (tick_graph), 0U};
+
     // TODO: Figure out game loop.
     glfwSwapInterval (g_vsync);
     // Loop until the user closes the window
     while (! glfwWindowShouldClose (window))
     {
+        const fost::clock::time_point frame_begin = fost::clock::now ();
+        const fost::alloc::counts frame_allocs = fost::alloc::thread_counts ();
+        FOST_PROFILE_ZONE ("frame");
         ++frame_count;
         // std::cout << "[Frame #" << frame_count << "] Start\n";
+        {
+            FOST_PROFILE_ZONE ("pace frame");
+            fost::runtime::pace_frame ();
+        }
+        const fost::clock::time_point work_begin = fost::clock::now ();
+
         // Poll Inputs.
-        glfwPollEvents ();
+        {
+            FOST_PROFILE_ZONE ("poll events");
+            glfwPollEvents ();
+            flush_input ();
+        }
 
         // FOST_LOG_INFO ("Frame debug: {}ms dt | {} fps", fost::runtime::frametime ().count (), fost::runtime::fps ());
         // IMPORTANT! Must cycle runtime to advance simulation (calculates delta time).
         fost::runtime::cycle ();
-        auto delta_time = fost::runtime::frame_time ();
-        // std::cout << "[Frame #" << frame_count << "] dt " << std::chrono::duration <float> (delta_time).count () << '\n';
+        // std::cout << "[Frame #" << frame_count << "] dt " << std::chrono::duration <float> (fost::runtime::frame_time ()).count () << '\n';
+        fost::profiler_panel::record_frame (fost::runtime::frame_time ());
 
-        if (delta_time > 250ms)
-            delta_time = 250ms;
+        // Ticks the simulation finished since the last frame.
+        const std::uint32_t frame_ticks = record_ticks (frame_tick_records);
 
-        accumulator += delta_time;
+        if (g_snapshots.update ())
+            current = g_snapshots.front ();
 
-        g_lens.cycle (fost::runtime::frame_time ()); // TODO: ?
-
-        // Update
-        while (accumulator >= fost::runtime::tick_unit)
+        // Start the Dear ImGui frame
+        if (imgui_frames++ % g_imgui_interval == 0U)
         {
-            // std::cout << "[Frame #" << frame_count << "] TICK NOW!\n";
-            // Window key handling.
-            if (key_down (GLFW_KEY_F1))
-            {
-                g_draw_hud = ! g_draw_hud;
-                std::cout << "Draw hud " << static_cast <int> (g_draw_hud) << '\n';
-            }
-            if (g_draw_hud && key_down (GLFW_KEY_F3))
-            {
-                g_draw_debug_hud = ! g_draw_debug_hud;
-                std::cout << "Draw debug hud " << static_cast <int> (g_draw_debug_hud) << '\n';
-            }
-
-            if (const auto amount = key_held (GLFW_KEY_H))
-            {
-                std::cout << "Held H for " << amount << '\n';
-            }
+            FOST_PROFILE_ZONE ("imgui frame");
+            ImGui_ImplOpenGL3_NewFrame ();
+            ImGui_ImplGlfw_NewFrame ();
+            ImGui::NewFrame ();
 
-            g_lens.tick (fost::runtime::tick_unit);
+            if (g_draw_hud && g_draw_debug_hud)
+                fost::profiler_panel::draw ();
 
-            prune_events ();
-            t += fost::runtime::tick_unit;
-            accumulator -= fost::runtime::tick_unit;
+            // Finish the Dear ImGui frame
+            ImGui::Render ();
         }
-        cycle_mouse_to_be_renamed ();
-
-        // Start the Dear ImGui frame
-        ImGui_ImplOpenGL3_NewFrame ();
-        ImGui_ImplGlfw_NewFrame ();
-        ImGui::NewFrame ();
-
-
-        // Finish the Dear ImGui frame
-        ImGui::Render ();
 
         // Rendering
-        const double alpha = std::chrono::duration <double> {accumulator} / fost::runtime::tick_unit;
-        const glm::vec3 final_pos = glm::mix (g_lens.prev_pos, g_lens.get_position (), alpha);
-        const glm::vec3 final_dir = glm::mix (g_lens.prev_dir, g_lens.get_direction (), alpha);
-        glm::mat4 view = glm::lookAt (final_pos, final_pos + final_dir, g_lens.get_upvector ());
+        FOST_PROFILE_ZONE ("render");
+        fost::gpu::begin_frame ();
+        // Blend the last two ticks by how far into the next one this frame is.
+        const double alpha = std::clamp (std::chrono::duration <double> {fost::clock::now () - current.time}
+                                         / current.interval, 0.0, 1.0);
+        const glm::vec3 final_pos = glm::mix (current.previous_position, current.position, alpha);
+        // Locking on or off is a jump, not something to blend.
+        const glm::vec3 final_dir = ! current.locked_on
+            ? look_direction (current, g_cursor_polled)
+            : (current.previous_locked_on ? glm::mix (current.previous_direction, current.direction, alpha)
+                                          : current.direction);
+        const glm::vec3 final_up = up_of (final_dir);
+        glm::mat4 view = glm::lookAt (final_pos, final_pos + final_dir, final_up);
 
         static const GLfloat background_color[] = { 0.2f, 0.2f, 0.2f, 1.0f };
         // glEnable (GL_DEPTH_TEST);
@@ -1108,6 +1687,7 @@ int main (int argc, char **argv)
         glUseProgram (prog);
 #if 1
         {
+            FOST_GPU_ZONE ("cube");
             glm::mat4 model {1.0f};
             // model = glm::translate (model, origin_vec3);
 
@@ -1141,10 +1721,11 @@ int main (int argc, char **argv)
             if (g_draw_debug_hud)
             {
                 // Draw debug crosshair
+                FOST_GPU_ZONE ("debug axes");
                 glBindVertexArray (axes_vao);
                 glUseProgram (axes_prog);
 
-                view = glm::lookAt (-g_lens.get_direction (), origin_vec3, g_lens.get_upvector ());
+                view = glm::lookAt (-final_dir, origin_vec3, final_up);
                 glUniformMatrix4fv (u_view_axes_prog, 1, GL_FALSE, &view[0][0]);
                 glUniformMatrix4fv (u_projection_axes_prog, 1, GL_FALSE, &g_projection[0][0]);
 
@@ -1165,12 +1746,35 @@ int main (int argc, char **argv)
         // glDisable (GL_DEPTH_TEST);
 
 
-        ImGui_ImplOpenGL3_RenderDrawData (ImGui::GetDrawData ());
+        {
+            FOST_PROFILE_ZONE ("imgui render");
+            FOST_GPU_ZONE ("imgui render");
+            ImGui_ImplOpenGL3_RenderDrawData (ImGui::GetDrawData ());
+        }
+        fost::gpu::end_frame ();
+        fost::quality::update (fost::clock::now () - work_begin);
+
+        {
+            FOST_PROFILE_ZONE ("swap buffers");
+            glfwSwapBuffers (window);
+        }
 
-        glfwSwapBuffers (window);
+        // The frame zone is still open here, it is collected next frame.
+        const fost::clock::duration frame_duration = fost::clock::now () - frame_begin;
+        const fost::alloc::counts frame_allocations = fost::alloc::since (frame_allocs);
+        fost::profiler_panel::record_allocations (frame_allocations);
+        fost::capture::record_frame (frame_begin, frame_duration, frame_ticks, frame_allocations);
+        fost::capture::collect_zones ();
+        fost::stream::record_frame (frame_begin, frame_duration, frame_ticks, frame_allocations);
+        fost::stream::collect_zones ();
+        fost::sampler::collect ();
         // std::cout << "[Frame #" << frame_count << "] End\n";
     }
     // Cleanup
+    g_simulating.store (false, std::memory_order_release);
+    simulation.join ();
+    stop_profiling (sample_path);
+    fost::gpu::shutdown ();
     ImGui_ImplOpenGL3_Shutdown ();
     ImGui_ImplGlfw_Shutdown ();
     ImPlot::DestroyContext ();
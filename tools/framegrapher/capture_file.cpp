@@ -0,0 +1,141 @@
+#include "capture_file.hpp"
+
+#include <cstring>
+
+using namespace fost::capture;
+
+namespace
+{
+
+template <class T>
+bool add_span (const uchar *data, const chunk_header &chunk,
+               QVector <capture_file::span <T>> &spans, std::size_t &total)
+{
+    if (chunk.bytes != static_cast <std::uint64_t> (chunk.count) * sizeof (T))
+        return false;
+
+    spans.append ({reinterpret_cast <const T*> (data), chunk.count});
+    total += chunk.count;
+    return true;
+}
+
+} // namespace
+
+bool capture_file::read_strings (const uchar *data, std::uint64_t bytes, std::uint32_t count,
+                                 QHash <std::uint32_t, QString> &out)
+{
+    std::uint64_t offset = 0;
+    for (std::uint32_t i = 0; i < count; ++i)
+    {
+        if (offset + sizeof (name_entry) > bytes)
+            return false;
+
+        name_entry entry;
+        std::memcpy (&entry, data + offset, sizeof (entry));
+        offset += sizeof (entry);
+        if (offset + entry.length > bytes)
+            return false;
+
+        out.insert (entry.id, QString::fromUtf8 (reinterpret_cast <const char*> (data + offset),
+                                                 static_cast <int> (entry.length)));
+        offset += padded_size (entry.length);
+    }
+    return true;
+}
+
+capture_file::~capture_file ()
+{
+    close ();
+}
+
+bool capture_file::fail (const QString &reason)
+{
+    close ();
+    _error = reason;
+    return false;
+}
+
+bool capture_file::open (const QString &path)
+{
+    close ();
+    _error.clear ();
+
+    _file.setFileName (path);
+    if (! _file.open (QIODevice::ReadOnly))
+        return fail (_file.errorString ());
+
+    const qint64 size = _file.size ();
+    if (size < static_cast <qint64> (sizeof (file_header)))
+        return fail (QObject::tr ("File is too small to be a capture."));
+
+    _map = _file.map (0, size);
+    if (! _map)
+        return fail (_file.errorString ());
+
+    _header = reinterpret_cast <const file_header*> (_map);
+    if (std::memcmp (_header->magic, magic, sizeof (magic)) != 0)
+        return fail (QObject::tr ("Not a blockytry capture."));
+    if (_header->version != version)
+        return fail (QObject::tr ("Unsupported capture version %1.").arg (_header->version));
+
+    std::uint64_t offset = sizeof (file_header);
+    const std::uint64_t end = static_cast <std::uint64_t> (size);
+    while (offset + sizeof (chunk_header) <= end)
+    {
+        chunk_header chunk;
+        std::memcpy (&chunk, _map + offset, sizeof (chunk));
+        offset += sizeof (chunk);
+
+        // A capture cut short by a crash ends in a partial chunk, keep the rest.
+        if (chunk.bytes > end - offset)
+            break;
+
+        const uchar *payload = _map + offset;
+        bool ok = true;
+        switch (chunk.type)
+        {
+            case chunk_type::frames:
+                ok = add_span (payload, chunk, _frames, _frame_count);
+                break;
+            case chunk_type::ticks:
+                ok = add_span (payload, chunk, _ticks, _tick_count);
+                break;
+            case chunk_type::zones:
+                ok = add_span (payload, chunk, _zones, _zone_count);
+                break;
+            case chunk_type::names:
+                ok = read_strings (payload, chunk.bytes, chunk.count, _names);
+                break;
+            case chunk_type::threads:
+                ok = read_strings (payload, chunk.bytes, chunk.count, _threads);
+                break;
+            default:
+                // Unknown chunks from newer writers are skipped.
+                break;
+        }
+        if (! ok)
+            return fail (QObject::tr ("Corrupt chunk at offset %1.").arg (offset - sizeof (chunk)));
+
+        offset += chunk.bytes;
+    }
+
+    return true;
+}
+
+void capture_file::close ()
+{
+    if (_map)
+        _file.unmap (_map);
+    _map = nullptr;
+    _header = nullptr;
+    _file.close ();
+
+    _frames.clear ();
+    _ticks.clear ();
+    _zones.clear ();
+    _frame_count = 0;
+    _tick_count = 0;
+    _zone_count = 0;
+    _names.clear ();
+    _threads.clear ();
+}
@@ -0,0 +1,77 @@
+#ifndef CAPTURE_FILE_HPP
+#define CAPTURE_FILE_HPP
+
+#include <core/capture_format.hpp>
+
+#include <QFile>
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+#include <cstddef>
+#include <cstdint>
+
+// Read-only view of a capture written by the game. The file is memory-mapped
+// and records are used in place, so opening costs one pass over chunk headers.
+class capture_file
+{
+public:
+    template <class T>
+    struct span
+    {
+        const T *data;
+        std::size_t size;
+
+        const T * begin () const { return data; }
+        const T * end () const { return data + size; }
+    };
+
+    capture_file () = default;
+    ~capture_file ();
+
+    capture_file (const capture_file &other) = delete;
+    capture_file & operator= (const capture_file &other) = delete;
+
+    // Maps path and indexes its chunks. On failure error () says why.
+    bool open (const QString &path);
+    void close ();
+
+    bool is_open () const { return _map != nullptr; }
+    const QString & error () const { return _error; }
+
+    const fost::capture::file_header & header () const { return *_header; }
+
+    const QVector <span <fost::capture::frame_entry>> & frames () const { return _frames; }
+    const QVector <span <fost::capture::tick_entry>> & ticks () const { return _ticks; }
+    const QVector <span <fost::capture::zone_entry>> & zones () const { return _zones; }
+
+    std::size_t frame_count () const { return _frame_count; }
+    std::size_t tick_count () const { return _tick_count; }
+    std::size_t zone_count () const { return _zone_count; }
+
+    QString zone_name (std::uint32_t id) const { return _names.value (id); }
+    QString thread_name (std::uint32_t id) const { return _threads.value (id); }
+
+    // Decodes the payload of a names or threads chunk into out.
+    static bool read_strings (const uchar *data, std::uint64_t bytes, std::uint32_t count,
+                              QHash <std::uint32_t, QString> &out);
+
+private:
+    bool fail (const QString &reason);
+
+    QFile _file;
+    uchar *_map = nullptr;
+    QString _error;
+
+    const fost::capture::file_header *_header = nullptr;
+    QVector <span <fost::capture::frame_entry>> _frames;
+    QVector <span <fost::capture::tick_entry>> _ticks;
+    QVector <span <fost::capture::zone_entry>> _zones;
+    std::size_t _frame_count = 0;
+    std::size_t _tick_count = 0;
+    std::size_t _zone_count = 0;
+    QHash <std::uint32_t, QString> _names;
+    QHash <std::uint32_t, QString> _threads;
+};
+
+#endif // CAPTURE_FILE_HPP
@@ -0,0 +1,106 @@
+#include "capture_stream.hpp"
+#include "capture_file.hpp"
+
+#include <QDir>
+#include <QProcessEnvironment>
+
+#include <cstring>
+
+using namespace fost::capture;
+
+capture_stream::capture_stream (QObject *parent)
+    : QObject (parent)
+{
+    connect (&_socket, &QLocalSocket::connected, this, &capture_stream::connected);
+    connect (&_socket, &QLocalSocket::disconnected, this, &capture_stream::disconnected);
+    connect (&_socket, &QLocalSocket::readyRead, this, &capture_stream::read_available);
+    connect (&_socket, &QLocalSocket::errorOccurred, this, [this] (QLocalSocket::LocalSocketError)
+    {
+        emit failed (_socket.errorString ());
+    });
+}
+
+QString capture_stream::default_socket_path ()
+{
+    const QString runtime_dir = QProcessEnvironment::systemEnvironment ().value ("XDG_RUNTIME_DIR");
+    return (runtime_dir.isEmpty () ? QStringLiteral ("/tmp") : runtime_dir) + "/blockytry-profiler.sock";
+}
+
+void capture_stream::connect_to (const QString &path)
+{
+    disconnect_from ();
+    _buffer.clear ();
+    _has_header = false;
+    _names.clear ();
+    _threads.clear ();
+    _socket.connectToServer (path, QIODevice::ReadOnly);
+}
+
+void capture_stream::disconnect_from ()
+{
+    _socket.abort ();
+}
+
+bool capture_stream::is_connected () const
+{
+    return _socket.state () == QLocalSocket::ConnectedState;
+}
+
+void capture_stream::read_available ()
+{
+    _buffer.append (_socket.readAll ());
+
+    qsizetype offset = 0;
+    if (! _has_header)
+    {
+        if (_buffer.size () < static_cast <qsizetype> (sizeof (file_header)))
+            return;
+
+        file_header header;
+        std::memcpy (&header, _buffer.constData (), sizeof (header));
+        if (std::memcmp (header.magic, magic, sizeof (magic)) != 0 || header.version != version)
+        {
+            emit failed (tr ("Peer does not speak capture version %1.").arg (version));
+            disconnect_from ();
+            return;
+        }
+        _has_header = true;
+        offset = sizeof (header);
+    }
+
+    // Chunks are decoded only once complete, a partial one waits for more bytes.
+    while (_buffer.size () - offset >= static_cast <qsizetype> (sizeof (chunk_header)))
+    {
+        chunk_header chunk;
+        std::memcpy (&chunk, _buffer.constData () + offset, sizeof (chunk));
+        if (static_cast <std::uint64_t> (_buffer.size () - offset) - sizeof (chunk) < chunk.bytes)
+            break;
+
+        // QByteArray data is suitably aligned for the 8 byte records.
+        const char *payload = _buffer.constData () + offset + sizeof (chunk);
+        const int count = static_cast <int> (chunk.count);
+        switch (chunk.type)
+        {
+            case chunk_type::frames:
+                emit frames_received (reinterpret_cast <const frame_entry*> (payload), count);
+                break;
+            case chunk_type::ticks:
+                emit ticks_received (reinterpret_cast <const tick_entry*> (payload), count);
+                break;
+            case chunk_type::zones:
+                emit zones_received (reinterpret_cast <const zone_entry*> (payload), count);
+                break;
+            // The game sends names before the first zone that refers to them.
+            case chunk_type::names:
+                capture_file::read_strings (reinterpret_cast <const uchar*> (payload), chunk.bytes, chunk.count, _names);
+                break;
+            case chunk_type::threads:
+                capture_file::read_strings (reinterpret_cast <const uchar*> (payload), chunk.bytes, chunk.count, _threads);
+                break;
+            default:
+                break;
+        }
+        offset += static_cast <qsizetype> (sizeof (chunk) + chunk.bytes);
+    }
+    _buffer.remove (0, offset);
+}
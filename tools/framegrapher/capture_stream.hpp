@@ -0,0 +1,54 @@
+#ifndef CAPTURE_STREAM_HPP
+#define CAPTURE_STREAM_HPP
+
+#include <core/capture_format.hpp>
+
+#include <QByteArray>
+#include <QHash>
+#include <QLocalSocket>
+#include <QObject>
+#include <QString>
+#include <QVector>
+
+#include <cstdint>
+
+// Live capture fed by a running game over its profiler socket. Incoming bytes
+// use the capture file format and are decoded chunk by chunk as they arrive.
+class capture_stream : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit capture_stream (QObject *parent = nullptr);
+
+    // Path the game listens on by default, see fost::stream::default_socket_path.
+    static QString default_socket_path ();
+
+    void connect_to (const QString &path);
+    void disconnect_from ();
+    bool is_connected () const;
+
+    // Names sent so far by the connected game, for the ids in zone records.
+    QString zone_name (std::uint32_t id) const { return _names.value (id); }
+    QString thread_name (std::uint32_t id) const { return _threads.value (id); }
+
+signals:
+    void connected ();
+    void disconnected ();
+    void failed (const QString &reason);
+    void frames_received (const fost::capture::frame_entry *frames, int count);
+    void ticks_received (const fost::capture::tick_entry *ticks, int count);
+    void zones_received (const fost::capture::zone_entry *zones, int count);
+
+private slots:
+    void read_available ();
+
+private:
+    QLocalSocket _socket;
+    QByteArray _buffer;
+    bool _has_header = false;
+    QHash <std::uint32_t, QString> _names;
+    QHash <std::uint32_t, QString> _threads;
+};
+
+#endif // CAPTURE_STREAM_HPP
@@ -21,5 +21,14 @@ int main (int argc, char *argv[])
     }
     main_window w;
     w.show ();
+
+    // framegrapher <capture.fcap>
+    // framegrapher --live [socket]
+    const QStringList args = a.arguments ();
+    if (args.size () > 1 && args.at (1) == "--live")
+        w.connect_live (args.size () > 2 ? args.at (2) : capture_stream::default_socket_path ());
+    else if (args.size () > 1)
+        w.load_capture (args.at (1));
+
     return a.exec ();
 }
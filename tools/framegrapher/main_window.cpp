@@ -1,20 +1,156 @@
 #include "main_window.hpp"
 #include "./ui_main_window.h"
 
+#include <QAbstractAxis>
+#include <QChart>
+#include <QElapsedTimer>
+#include <QFileDialog>
+#include <QInputDialog>
+#include <QLineEdit>
 #include <QLineSeries>
+#include <QMenuBar>
+#include <QMessageBox>
+#include <QPair>
+#include <QPointF>
+#include <QStatusBar>
+#include <QStringList>
+#include <QVector>
+
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+
+// Points plotted per series. Charts slow to a crawl well before a million
+// points, so long captures are reduced to the min and max of each bucket,
+// which keeps every spike visible.
+constexpr std::size_t max_points = 8192;
+
+// Seconds of history kept on screen while following a live game.
+constexpr double live_window_s = 20.0;
+
+// Busiest zones listed while following a live game, refreshed every second.
+constexpr int live_zones_shown = 5;
+constexpr qint64 live_zones_interval_ms = 1000;
+
+// Appends one point per record and drops those older than the live window.
+template <class T>
+void append_live (QVector <QPointF> &points, const T *entries, int count)
+{
+    for (int i = 0; i < count; ++i)
+        points.append ({entries[i].begin_ns / 1e9, entries[i].duration_ns / 1e6});
+
+    if (points.isEmpty ())
+        return;
+    const double oldest = points.last ().x () - live_window_s;
+    int stale = 0;
+    while (stale < points.size () && points[stale].x () < oldest)
+        ++stale;
+    points.remove (0, stale);
+}
+
+template <class T>
+QVector <QPointF> decimate (const QVector <capture_file::span <T>> &spans, std::size_t count)
+{
+    QVector <QPointF> points;
+    if (! count)
+        return points;
+
+    const std::size_t bucket = std::max <std::size_t> (1, (count * 2 + max_points - 1) / max_points);
+    points.reserve (static_cast <int> ((count / bucket + 1) * 2));
+
+    std::size_t in_bucket = 0;
+    QPointF lo {0.0, std::numeric_limits <double>::max ()};
+    QPointF hi {0.0, std::numeric_limits <double>::lowest ()};
+    for (const auto &span : spans)
+    {
+        for (const T &e : span)
+        {
+            const QPointF p {e.begin_ns / 1e9, e.duration_ns / 1e6};
+            if (p.y () < lo.y ())
+                lo = p;
+            if (p.y () > hi.y ())
+                hi = p;
+
+            if (++in_bucket == bucket)
+            {
+                points.append (lo.x () < hi.x () ? lo : hi);
+                if (bucket > 1)
+                    points.append (lo.x () < hi.x () ? hi : lo);
+                in_bucket = 0;
+                lo.setY (std::numeric_limits <double>::max ());
+                hi.setY (std::numeric_limits <double>::lowest ());
+            }
+        }
+    }
+    if (in_bucket)
+    {
+        points.append (lo.x () < hi.x () ? lo : hi);
+        points.append (lo.x () < hi.x () ? hi : lo);
+    }
+    return points;
+}
+
+} // namespace
 
 main_window::main_window (QWidget *parent)
     : QMainWindow (parent)
     , ui (new Ui::main_window)
+    , _frame_series (new QLineSeries ())
+    , _tick_series (new QLineSeries ())
 {
     ui->setupUi (this);
 
-    QLineSeries *series = new QLineSeries ();
-    series->append (0, 6);
-    series->append (2, 4);
+    QMenu *file_menu = menuBar ()->addMenu (tr ("&File"));
+    file_menu->addAction (tr ("&Open capture..."), this, &main_window::open_capture, QKeySequence::Open);
+    file_menu->addAction (tr ("&Connect to game..."), this, &main_window::ask_connect_live);
+
+    _frame_series->setName (tr ("Frame time (ms)"));
+    _tick_series->setName (tr ("Tick time (ms)"));
+    _frame_series->setUseOpenGL (true);
+    _tick_series->setUseOpenGL (true);
 
-    ui->chartView->chart ()->addSeries (series);
+    ui->chartView->chart ()->addSeries (_frame_series);
+    ui->chartView->chart ()->addSeries (_tick_series);
     ui->chartView->chart ()->createDefaultAxes ();
+
+    connect (&_stream, &capture_stream::frames_received, this,
+             [this] (const fost::capture::frame_entry *frames, int count)
+    {
+        append_live (_live_frames, frames, count);
+        _live_dirty = true;
+    });
+    connect (&_stream, &capture_stream::ticks_received, this,
+             [this] (const fost::capture::tick_entry *ticks, int count)
+    {
+        append_live (_live_ticks, ticks, count);
+        _live_dirty = true;
+    });
+    connect (&_stream, &capture_stream::zones_received, this,
+             [this] (const fost::capture::zone_entry *zones, int count)
+    {
+        for (int i = 0; i < count; ++i)
+            _live_zones[(quint64 {zones[i].thread_id} << 32) | zones[i].name_id] += zones[i].end_ns - zones[i].begin_ns;
+    });
+    connect (&_stream, &capture_stream::connected, this, [this] ()
+    {
+        statusBar ()->showMessage (tr ("Connected to game."));
+    });
+    connect (&_stream, &capture_stream::disconnected, this, [this] ()
+    {
+        _live_timer.stop ();
+        statusBar ()->showMessage (tr ("Game disconnected."));
+    });
+    connect (&_stream, &capture_stream::failed, this, [this] (const QString &reason)
+    {
+        _live_timer.stop ();
+        statusBar ()->showMessage (tr ("Live view failed: %1").arg (reason));
+    });
+
+    // Redraw at a steady rate however fast records arrive.
+    _live_timer.setInterval (33);
+    connect (&_live_timer, &QTimer::timeout, this, &main_window::refresh_live);
 }
 
 main_window::~main_window ()
@@ -22,3 +158,153 @@ main_window::~main_window ()
     delete ui;
 }
 
+void main_window::reset_axes ()
+{
+    QChart *chart = ui->chartView->chart ();
+    for (QAbstractAxis *axis : chart->axes ())
+    {
+        chart->removeAxis (axis);
+        delete axis;
+    }
+    chart->createDefaultAxes ();
+}
+
+bool main_window::load_capture (const QString &path)
+{
+    _stream.disconnect_from ();
+    _live_timer.stop ();
+
+    QElapsedTimer timer;
+    timer.start ();
+
+    if (! _capture.open (path))
+    {
+        QMessageBox::warning (this, tr ("Open capture"), _capture.error ());
+        return false;
+    }
+    const qint64 map_ms = timer.elapsed ();
+
+    _frame_series->replace (decimate (_capture.frames (), _capture.frame_count ()));
+    _tick_series->replace (decimate (_capture.ticks (), _capture.tick_count ()));
+
+    reset_axes ();
+
+    // Only games built with allocation tracking fill these in.
+    quint64 allocations = 0;
+    std::size_t allocating_frames = 0;
+    for (const auto &span : _capture.frames ())
+    {
+        for (const fost::capture::frame_entry &frame : span)
+        {
+            allocations += frame.allocations;
+            allocating_frames += (frame.allocations != 0);
+        }
+    }
+
+    setWindowTitle (path);
+    QString message = tr ("%1 frames, %2 ticks, %3 zones at %4 tps. Mapped in %5 ms, plotted in %6 ms.")
+        .arg (_capture.frame_count ())
+        .arg (_capture.tick_count ())
+        .arg (_capture.zone_count ())
+        .arg (_capture.header ().tps)
+        .arg (map_ms)
+        .arg (timer.elapsed () - map_ms);
+    if (allocations)
+        message += tr (" %1 allocations, %2 frames allocated.").arg (allocations).arg (allocating_frames);
+    statusBar ()->showMessage (message);
+    return true;
+}
+
+void main_window::open_capture ()
+{
+    const QString path = QFileDialog::getOpenFileName (this, tr ("Open capture"), QString (),
+                                                       tr ("Blockytry captures (*.fcap);;All files (*)"));
+    if (! path.isEmpty ())
+        load_capture (path);
+}
+
+void main_window::connect_live (const QString &socket_path)
+{
+    _capture.close ();
+    _live_frames.clear ();
+    _live_ticks.clear ();
+    _live_zones.clear ();
+    _live_zones_timer.start ();
+    _frame_series->clear ();
+    _tick_series->clear ();
+
+    setWindowTitle (socket_path);
+    statusBar ()->showMessage (tr ("Connecting to %1...").arg (socket_path));
+    _stream.connect_to (socket_path);
+    _live_timer.start ();
+}
+
+void main_window::ask_connect_live ()
+{
+    bool ok = false;
+    const QString path = QInputDialog::getText (this, tr ("Connect to game"), tr ("Profiler socket:"),
+                                                QLineEdit::Normal, capture_stream::default_socket_path (), &ok);
+    if (ok && ! path.isEmpty ())
+        connect_live (path);
+}
+
+void main_window::refresh_live ()
+{
+    if (_live_zones_timer.elapsed () >= live_zones_interval_ms)
+        show_live_zones ();
+
+    if (! _live_dirty)
+        return;
+    _live_dirty = false;
+
+    _frame_series->replace (_live_frames);
+    _tick_series->replace (_live_ticks);
+
+    double max_ms = 1.0;
+    for (const QPointF &p : _live_frames)
+        max_ms = std::max (max_ms, p.y ());
+    for (const QPointF &p : _live_ticks)
+        max_ms = std::max (max_ms, p.y ());
+
+    QChart *chart = ui->chartView->chart ();
+    if (! _live_frames.isEmpty ())
+    {
+        const double newest = _live_frames.last ().x ();
+        chart->axes (Qt::Horizontal).first ()->setRange (newest - live_window_s, newest);
+    }
+    chart->axes (Qt::Vertical).first ()->setRange (0.0, max_ms * 1.1);
+}
+
+// Lists the zones that took the most time since the last call, per second so
+// the figures do not depend on how often this runs.
+void main_window::show_live_zones ()
+{
+    const double seconds = std::max <qint64> (1, _live_zones_timer.restart ()) / 1e3;
+
+    QVector <QPair <quint64, qint64>> ranked;
+    ranked.reserve (_live_zones.size ());
+    for (auto it = _live_zones.cbegin (); it != _live_zones.cend (); ++it)
+        ranked.append ({it.key (), it.value ()});
+    _live_zones.clear ();
+    if (ranked.isEmpty ())
+        return;
+
+    const int shown = std::min (live_zones_shown, static_cast <int> (ranked.size ()));
+    std::partial_sort (ranked.begin (), ranked.begin () + shown, ranked.end (),
+                       [] (const QPair <quint64, qint64> &a, const QPair <quint64, qint64> &b)
+    {
+        return a.second > b.second;
+    });
+
+    QStringList busiest;
+    for (int i = 0; i < shown; ++i)
+    {
+        const std::uint32_t name_id = static_cast <std::uint32_t> (ranked[i].first);
+        const std::uint32_t thread_id = static_cast <std::uint32_t> (ranked[i].first >> 32);
+        busiest.append (tr ("%1 (%2) %3 ms/s")
+            .arg (_stream.zone_name (name_id))
+            .arg (_stream.thread_name (thread_id))
+            .arg (ranked[i].second / 1e6 / seconds, 0, 'f', 1));
+    }
+    statusBar ()->showMessage (tr ("Busiest zones: %1").arg (busiest.join (", ")));
+}
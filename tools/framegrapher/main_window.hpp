@@ -1,10 +1,19 @@
 #ifndef MAIN_WINDOW_HPP
 #define MAIN_WINDOW_HPP
 
+#include "capture_file.hpp"
+#include "capture_stream.hpp"
+
+#include <QElapsedTimer>
+#include <QHash>
 #include <QMainWindow>
+#include <QPointF>
+#include <QTimer>
+#include <QVector>
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class main_window; }
+class QLineSeries;
 QT_END_NAMESPACE
 
 class main_window : public QMainWindow
@@ -15,7 +24,34 @@ public:
     main_window (QWidget *parent = nullptr);
     ~main_window ();
 
+    // Loads a binary capture written by the game and plots it.
+    bool load_capture (const QString &path);
+
+    // Follows a running game over its profiler socket.
+    void connect_live (const QString &socket_path);
+
+private slots:
+    void open_capture ();
+    void ask_connect_live ();
+    void refresh_live ();
+
 private:
+    void reset_axes ();
+    void show_live_zones ();
+
     Ui::main_window *ui;
+    QLineSeries *_frame_series;
+    QLineSeries *_tick_series;
+    capture_file _capture;
+
+    capture_stream _stream;
+    QTimer _live_timer;
+    QVector <QPointF> _live_frames;
+    QVector <QPointF> _live_ticks;
+    bool _live_dirty = false;
+    // Nanoseconds spent per zone since the last summary, keyed by thread id
+    // in the high half and zone name id in the low half.
+    QHash <quint64, qint64> _live_zones;
+    QElapsedTimer _live_zones_timer;
 };
 #endif // MAIN_WINDOW_HPP